@@ -0,0 +1,407 @@
+//-----------------------------------------------------------------------------
+// Purpose: Micro-benchmarks of the head tracking hot path outside SteamVR:
+//          axis decoding, quaternion math, filtering, prediction, publish
+//          throttling, distortion lookup and the driver log. Build Release
+//          for meaningful numbers.
+//
+//          glyph_bench [iterations] [recording]
+//
+//          With a recording made through the recordFile setting, the pose
+//          stages run over its samples instead of the synthetic sweep.
+//-----------------------------------------------------------------------------
+
+#include "../glyph_pose.h"
+#include "../glyph_axis_map.h"
+#include "../glyph_sample.h"
+#include "../glyph_time.h"
+#include "../glyph_record.h"
+#include "../glyph_optics.h"
+#include "../driverlog.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// swallows everything the driver logs during the logging benchmarks
+class CNullDriverLog : public vr::IVRDriverLog
+{
+public:
+	CNullDriverLog() : m_unLines(0) {}
+	virtual void Log(const char *pchLogMessage) { m_unLines++; }
+	uint32_t m_unLines;
+};
+
+// results are folded into this so the optimizer cannot drop the work
+static double g_flChecksum = 0.0;
+
+static void Report(const char *pchName, uint32_t unIterations, int64_t nTicks)
+{
+	double flSeconds = GlyphTicksToSeconds(nTicks);
+	printf("%-28s %10.1f ns/op %10.2f Mops/s\n", pchName, 1e9 * flSeconds / unIterations, unIterations / flSeconds / 1e6);
+}
+
+// A head sweeping about yaw and nodding, sampled at 500 Hz, as the tracker
+// would report it: quantized axes, 0..65535 per turn around the forward value.
+static void MakeSyntheticSamples(uint32_t unCount, std::vector<GlyphSample_t> *pSamples)
+{
+	const int64_t nInterval = GlyphTicksPerSecond() / 500;
+	pSamples->resize(unCount);
+
+	for (uint32_t i = 0; i < unCount; i++) {
+		double t = i / 500.0;
+		GlyphSample_t &sample = (*pSamples)[i];
+		memset(&sample, 0, sizeof(sample));
+		sample.unSequence = i;
+		sample.nTimestamp = i * nInterval;
+		sample.rgnAxis[GlyphAxis_Z] = 32767 + (int32_t)(4000 * sin(2.1 * t));
+		sample.rgnAxis[GlyphAxis_RX] = 32767 + (int32_t)(12000 * sin(0.7 * t));
+		sample.rgnAxis[GlyphAxis_Y] = 32767 + (int32_t)(1500 * sin(1.3 * t));
+	}
+}
+
+static bool LoadRecordedSamples(const char *pchPath, std::vector<GlyphSample_t> *pSamples)
+{
+	CGlyphRecordingReader reader;
+	if (!reader.Open(pchPath) || reader.GetCount() < 2) {
+		fprintf(stderr, "%s is not a usable tracker recording\n", pchPath);
+		return false;
+	}
+
+	pSamples->resize((size_t)reader.GetCount());
+	for (uint64_t i = 0; i < reader.GetCount(); i++)
+		reader.GetSample(i, &(*pSamples)[(size_t)i]);
+	return true;
+}
+
+static vr::HmdQuaternion_t SampleToRotation(const GlyphSample_t &sample)
+{
+	return GlyphAxesToRotation(sample.rgnAxis[GlyphAxis_Z], sample.rgnAxis[GlyphAxis_RX], sample.rgnAxis[GlyphAxis_Y]);
+}
+
+static void AccumulateChecksum(const vr::HmdQuaternion_t &q)
+{
+	g_flChecksum += q.w + q.x + q.y + q.z;
+}
+
+static void BenchAxesToRotation(const std::vector<GlyphSample_t> &samples, uint32_t unIterations)
+{
+	int64_t nStart = GlyphTicksNow();
+	for (uint32_t i = 0; i < unIterations; i++)
+		AccumulateChecksum(SampleToRotation(samples[i % samples.size()]));
+	Report("GlyphAxesToRotation", unIterations, GlyphTicksNow() - nStart);
+}
+
+// the default mapping through the kernel the driver selects at activation,
+// which costs the indirect call over GlyphAxesToRotation
+static void BenchAxisKernel(const std::vector<GlyphSample_t> &samples, uint32_t unIterations)
+{
+	GlyphAxisMapping_t mapping;
+	GlyphDefaultAxisMapping(&mapping);
+	GlyphAxisKernelConstants_t constants;
+	GlyphAxisKernel_t pfnKernel = GlyphSelectAxisKernel(mapping, &constants);
+
+	int64_t nStart = GlyphTicksNow();
+	for (uint32_t i = 0; i < unIterations; i++)
+		AccumulateChecksum(pfnKernel(samples[i % samples.size()], constants));
+	Report("Axis kernel", unIterations, GlyphTicksNow() - nStart);
+}
+
+// deg2rad and HmdQuaternion_Rotate as the original driver had them in
+// osvr_glyph.cpp, with only the vr:: qualification added: the three axis
+// angles summed as if they were one quaternion each and normalized
+inline double deg2rad(double deg) {
+	static const double pi_on_180 = 4.0 * atan(1.0) / 180.0;
+	return deg * pi_on_180;
+}
+
+inline vr::HmdQuaternion_t HmdQuaternion_Rotate(double xAngle, double yAngle, double zAngle)
+{
+	double x = 1.0 * sin(deg2rad(xAngle) / 2);
+	double y = 0.0 * sin(deg2rad(xAngle) / 2);
+	double z = 0.0 * sin(deg2rad(xAngle) / 2);
+	double w = cos(deg2rad(xAngle) / 2);
+
+	x += 0.0 * sin(deg2rad(yAngle) / 2);
+	y += 1.0 * sin(deg2rad(yAngle) / 2);
+	z += 0.0 * sin(deg2rad(yAngle) / 2);
+	w += cos(deg2rad(yAngle) / 2);
+
+	x += 0.0 * sin(deg2rad(zAngle) / 2);
+	y += 0.0 * sin(deg2rad(zAngle) / 2);
+	z += 1.0 * sin(deg2rad(zAngle) / 2);
+	w += cos(deg2rad(zAngle) / 2);
+
+	double mag = sqrt(w*w + x*x + y*y + z*z);
+
+	return { w / mag, x / mag, y / mag, z / mag };
+}
+
+// the original GetPose conversion, for comparison
+static void BenchOriginalRotate(const std::vector<GlyphSample_t> &samples, uint32_t unIterations)
+{
+	int64_t nStart = GlyphTicksNow();
+	for (uint32_t i = 0; i < unIterations; i++) {
+		const GlyphSample_t &sample = samples[i % samples.size()];
+		double degX = (360.0 / 65535.0) * (sample.rgnAxis[GlyphAxis_Z]) + 180;
+		double degY = (360.0 / 65535.0) * (sample.rgnAxis[GlyphAxis_RX]) + 180;
+		double degZ = -(360.0 / 65535.0) * (sample.rgnAxis[GlyphAxis_Y]) + 180;
+
+		AccumulateChecksum(HmdQuaternion_Rotate(degX, degY, degZ));
+	}
+	Report("HmdQuaternion_Rotate (orig)", unIterations, GlyphTicksNow() - nStart);
+}
+
+static void BenchPrediction(const std::vector<GlyphSample_t> &samples, uint32_t unIterations)
+{
+	CGlyphPosePredictor predictor;
+	const int64_t nSpan = samples.back().nTimestamp + (samples[1].nTimestamp - samples[0].nTimestamp);
+
+	int64_t nStart = GlyphTicksNow();
+	for (uint32_t i = 0; i < unIterations; i++) {
+		const GlyphSample_t &sample = samples[i % samples.size()];
+		// keep time moving forward when the sample set wraps around
+		int64_t nTimestamp = sample.nTimestamp + (int64_t)(i / samples.size()) * nSpan;
+
+		vr::HmdQuaternion_t qRotation = SampleToRotation(sample);
+		predictor.AddSample(qRotation, nTimestamp);
+		AccumulateChecksum(predictor.Extrapolate(qRotation, 0.016));
+	}
+	Report("Decode + predict", unIterations, GlyphTicksNow() - nStart);
+}
+
+static void BenchOrientationFilter(const std::vector<GlyphSample_t> &samples, uint32_t unIterations)
+{
+	CGlyphOrientationFilter filter;
+	filter.Configure(1.0, 20.0, 1.0);
+	const int64_t nSpan = samples.back().nTimestamp + (samples[1].nTimestamp - samples[0].nTimestamp);
+
+	int64_t nStart = GlyphTicksNow();
+	for (uint32_t i = 0; i < unIterations; i++) {
+		const GlyphSample_t &sample = samples[i % samples.size()];
+		int64_t nTimestamp = sample.nTimestamp + (int64_t)(i / samples.size()) * nSpan;
+		AccumulateChecksum(filter.Filter(SampleToRotation(sample), nTimestamp));
+	}
+	Report("Decode + one euro filter", unIterations, GlyphTicksNow() - nStart);
+}
+
+static void BenchPublishThrottle(const std::vector<GlyphSample_t> &samples, uint32_t unIterations)
+{
+	CGlyphPublishThrottle throttle;
+	throttle.Configure(0.01 * 3.14159265358979323846 / 180.0, 1.0 / 240.0, 0.1);
+	const int64_t nSpan = samples.back().nTimestamp + (samples[1].nTimestamp - samples[0].nTimestamp);
+
+	int64_t nStart = GlyphTicksNow();
+	for (uint32_t i = 0; i < unIterations; i++) {
+		const GlyphSample_t &sample = samples[i % samples.size()];
+		int64_t nNow = sample.nTimestamp + (int64_t)(i / samples.size()) * nSpan;
+
+		vr::HmdQuaternion_t qRotation = SampleToRotation(sample);
+		if (throttle.Update(qRotation, true, false, nNow))
+			throttle.OnPublished(qRotation, nNow);
+	}
+	Report("Decode + publish throttle", unIterations, GlyphTicksNow() - nStart);
+	printf("%-28s published %llu, suppressed %llu\n", "", (unsigned long long)throttle.GetPublishedCount(), (unsigned long long)throttle.GetSuppressedCount());
+}
+
+// roughly the Glyph's pincushion correction with some lateral color
+static void MakeBenchOptics(GlyphOptics_t *pOptics)
+{
+	GlyphDefaultOptics(pOptics);
+	pOptics->rgflRadial[0] = 0.22f;
+	pOptics->rgflRadial[1] = 0.24f;
+	pOptics->rgflChannelScale[0] = 0.994f;
+	pOptics->rgflChannelScale[2] = 1.008f;
+	pOptics->flLensCenterOffset = 0.05f;
+}
+
+static void AccumulateChecksum(const vr::DistortionCoordinates_t &coordinates)
+{
+	g_flChecksum += coordinates.rfRed[0] + coordinates.rfGreen[1] + coordinates.rfBlue[0];
+}
+
+// --------------------------------------------------------------------------
+// Purpose: One eye's distortion sampled on a regular grid over the viewport
+//          and bilinearly interpolated between the four surrounding points,
+//          the alternative to evaluating the lens model per vertex as
+//          ComputeDistortion does
+// --------------------------------------------------------------------------
+class CGlyphDistortionGrid
+{
+public:
+	// grid points per side; the compositor's own mesh is coarser than this
+	static const uint32_t k_unGridSize = 65;
+
+	CGlyphDistortionGrid();
+
+	void Build(const GlyphOptics_t &optics, vr::EVREye eEye);
+
+	vr::DistortionCoordinates_t Lookup(float fU, float fV) const;
+
+private:
+	struct GridPoint_t
+	{
+		float rgflRed[2];
+		float rgflGreen[2];
+		float rgflBlue[2];
+	};
+
+	GridPoint_t m_rgPoints[k_unGridSize * k_unGridSize];
+	bool m_bIdentity;
+};
+
+static float Clamp01(float fValue)
+{
+	return fValue < 0.0f ? 0.0f : fValue > 1.0f ? 1.0f : fValue;
+}
+
+CGlyphDistortionGrid::CGlyphDistortionGrid()
+	: m_bIdentity(true)
+{
+}
+
+void CGlyphDistortionGrid::Build(const GlyphOptics_t &optics, vr::EVREye eEye)
+{
+	m_bIdentity = GlyphOpticsIsIdentity(optics);
+	if (m_bIdentity)
+		return;
+
+	const float flStep = 1.0f / (k_unGridSize - 1);
+	for (uint32_t v = 0; v < k_unGridSize; v++) {
+		for (uint32_t u = 0; u < k_unGridSize; u++) {
+			vr::DistortionCoordinates_t coordinates = GlyphEvaluateDistortion(optics, eEye, u * flStep, v * flStep);
+
+			GridPoint_t &point = m_rgPoints[v * k_unGridSize + u];
+			for (int i = 0; i < 2; i++) {
+				point.rgflRed[i] = coordinates.rfRed[i];
+				point.rgflGreen[i] = coordinates.rfGreen[i];
+				point.rgflBlue[i] = coordinates.rfBlue[i];
+			}
+		}
+	}
+}
+
+vr::DistortionCoordinates_t CGlyphDistortionGrid::Lookup(float fU, float fV) const
+{
+	vr::DistortionCoordinates_t coordinates;
+	if (m_bIdentity) {
+		coordinates.rfRed[0] = coordinates.rfGreen[0] = coordinates.rfBlue[0] = fU;
+		coordinates.rfRed[1] = coordinates.rfGreen[1] = coordinates.rfBlue[1] = fV;
+		return coordinates;
+	}
+
+	float x = Clamp01(fU) * (k_unGridSize - 1);
+	float y = Clamp01(fV) * (k_unGridSize - 1);
+	uint32_t u = x < k_unGridSize - 1 ? (uint32_t)x : k_unGridSize - 2;
+	uint32_t v = y < k_unGridSize - 1 ? (uint32_t)y : k_unGridSize - 2;
+	float fx = x - u;
+	float fy = y - v;
+
+	const GridPoint_t &p00 = m_rgPoints[v * k_unGridSize + u];
+	const GridPoint_t &p10 = m_rgPoints[v * k_unGridSize + u + 1];
+	const GridPoint_t &p01 = m_rgPoints[(v + 1) * k_unGridSize + u];
+	const GridPoint_t &p11 = m_rgPoints[(v + 1) * k_unGridSize + u + 1];
+
+	float w00 = (1.0f - fx) * (1.0f - fy);
+	float w10 = fx * (1.0f - fy);
+	float w01 = (1.0f - fx) * fy;
+	float w11 = fx * fy;
+	for (int i = 0; i < 2; i++) {
+		coordinates.rfRed[i] = w00 * p00.rgflRed[i] + w10 * p10.rgflRed[i] + w01 * p01.rgflRed[i] + w11 * p11.rgflRed[i];
+		coordinates.rfGreen[i] = w00 * p00.rgflGreen[i] + w10 * p10.rgflGreen[i] + w01 * p01.rgflGreen[i] + w11 * p11.rgflGreen[i];
+		coordinates.rfBlue[i] = w00 * p00.rgflBlue[i] + w10 * p10.rgflBlue[i] + w01 * p01.rgflBlue[i] + w11 * p11.rgflBlue[i];
+	}
+	return coordinates;
+}
+
+// the compositor walks a mesh over the viewport, so do the same
+static void BenchDistortion(bool bLookup, uint32_t unIterations)
+{
+	const uint32_t unMeshSize = 43;
+	GlyphOptics_t optics;
+	MakeBenchOptics(&optics);
+
+	int64_t nStart = GlyphTicksNow();
+	CGlyphDistortionGrid grid;
+	if (bLookup)
+		grid.Build(optics, vr::Eye_Left);
+	int64_t nBuildTicks = GlyphTicksNow() - nStart;
+
+	nStart = GlyphTicksNow();
+	for (uint32_t i = 0; i < unIterations; i++) {
+		uint32_t unVertex = i % (unMeshSize * unMeshSize);
+		float fU = (unVertex % unMeshSize) / (float)(unMeshSize - 1);
+		float fV = (unVertex / unMeshSize) / (float)(unMeshSize - 1);
+		AccumulateChecksum(bLookup ? grid.Lookup(fU, fV) : GlyphEvaluateDistortion(optics, vr::Eye_Left, fU, fV));
+	}
+	Report(bLookup ? "Distortion (grid lookup)" : "Distortion (evaluated)", unIterations, GlyphTicksNow() - nStart);
+	if (bLookup)
+		printf("%-28s grid built in %.3f ms\n", "", 1000.0 * GlyphTicksToSeconds(nBuildTicks));
+}
+
+static void BenchDriverLog(bool bAsynchronous, uint32_t unIterations)
+{
+	CNullDriverLog nullLog;
+	InitDriverLog(&nullLog, bAsynchronous);
+
+	int64_t nStart = GlyphTicksNow();
+	for (uint32_t i = 0; i < unIterations; i++)
+		DriverLog("Pose %u: %f %f %f %f\n", i, 1.0, 0.0, 0.0, 0.0);
+	int64_t nTicks = GlyphTicksNow() - nStart;
+
+	CleanupDriverLog();
+	Report(bAsynchronous ? "DriverLog (async)" : "DriverLog (sync)", unIterations, nTicks);
+	printf("%-28s %u of %u lines reached the log\n", "", nullLog.m_unLines, unIterations);
+}
+
+static void BenchRateLimitedLog(uint32_t unIterations)
+{
+	CNullDriverLog nullLog;
+	InitDriverLog(&nullLog, false);
+
+	int64_t nStart = GlyphTicksNow();
+	for (uint32_t i = 0; i < unIterations; i++)
+		DRIVERLOG_RATE_LIMITED(DriverLogLevel_Info, 10000, "GetEyeOutput Left Eye (%i, %i, %i, %i)\n", 0, 0, 1280, 720);
+	int64_t nTicks = GlyphTicksNow() - nStart;
+
+	CleanupDriverLog();
+	Report("DriverLog (rate limited)", unIterations, nTicks);
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t unIterations = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 1000000;
+	if (unIterations == 0) {
+		fprintf(stderr, "usage: glyph_bench [iterations] [recording]\n");
+		return 1;
+	}
+
+	std::vector<GlyphSample_t> samples;
+	if (argc > 2) {
+		if (!LoadRecordedSamples(argv[2], &samples))
+			return 1;
+		printf("%u iterations over %u samples from %s\n\n", unIterations, (uint32_t)samples.size(), argv[2]);
+	}
+	else {
+		MakeSyntheticSamples(5000, &samples);
+		printf("%u iterations over %u synthetic samples\n\n", unIterations, (uint32_t)samples.size());
+	}
+
+	BenchAxesToRotation(samples, unIterations);
+	BenchAxisKernel(samples, unIterations);
+	BenchOriginalRotate(samples, unIterations);
+	BenchOrientationFilter(samples, unIterations);
+	BenchPrediction(samples, unIterations);
+	BenchPublishThrottle(samples, unIterations);
+	BenchDistortion(false, unIterations);
+	BenchDistortion(true, unIterations);
+
+	// the async ring holds a few hundred lines, so keep this run short enough to show drops rather than hide them
+	uint32_t unLogIterations = unIterations / 10 > 0 ? unIterations / 10 : 1;
+	BenchDriverLog(false, unLogIterations);
+	BenchDriverLog(true, unLogIterations);
+	BenchRateLimitedLog(unIterations);
+
+	printf("\nchecksum %f\n", g_flChecksum);
+	return 0;
+}
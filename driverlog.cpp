@@ -4,39 +4,250 @@
 
 #include <stdio.h>
 #include <stdarg.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 
 static vr::IVRDriverLog * s_pLogFile = NULL;
 
+static std::atomic<int> s_nLogLevel(DriverLogLevel_Info);
 
-bool InitDriverLog(vr::IVRDriverLog *pDriverLog)
+static const char * const k_rgchLogLevelNames[] = { "debug", "info", "warning", "error" };
+
+static const uint32_t k_unLogMessageSize = 1024;
+
+// --------------------------------------------------------------------------
+// Asynchronous mode: callers format into a slot of a preallocated ring and a
+// background thread hands the finished lines to IVRDriverLog, so no thread
+// waits on vrserver's log I/O. Formatting stays on the caller's thread since
+// arguments such as %s strings may not outlive the call. The ring is a
+// bounded multi-producer, single-consumer queue; each slot's sequence says
+// whether it is free for the producer at that position or ready for the
+// consumer. When the ring is full the message is dropped and counted.
+// The thread sleeps on a condition variable while the ring is empty and a
+// producer wakes it only when it is asleep, so an idle driver costs no
+// wakeups; the timed wait is a fallback, not a polling interval.
+// --------------------------------------------------------------------------
+static const uint32_t k_unLogRingSize = 256;	// must be a power of two
+static const uint32_t k_unLogFallbackFlushMs = 1000;
+
+struct LogSlot_t
+{
+	std::atomic<uint32_t> unSequence;
+	char rchMessage[k_unLogMessageSize];
+};
+
+static LogSlot_t s_rgLogRing[k_unLogRingSize];
+static std::atomic<uint32_t> s_unLogEnqueuePos(0);
+static uint32_t s_unLogDequeuePos = 0;
+static std::atomic<uint32_t> s_unLogDropped(0);
+static std::atomic<bool> s_bLogThreadRunning(false);
+static std::thread *s_pLogThread = NULL;
+static std::mutex s_logWakeMutex;
+static std::condition_variable s_logWake;
+static std::atomic<bool> s_bLogThreadWaiting(false);
+
+static void FormatLogMessage(char(&rchMessage)[k_unLogMessageSize], const char *pMsgFormat, va_list args)
+{
+#if defined( _WIN32 )
+	vsprintf_s(rchMessage, pMsgFormat, args);
+#else
+	vsnprintf(rchMessage, sizeof(rchMessage), pMsgFormat, args);
+#endif
+}
+
+// Called after publishing a slot. Pairs with the fence in LogThreadFunction:
+// either the log thread sees the slot before it sleeps, or this sees it
+// waiting; the log thread holds the mutex from its check until it waits, so
+// the notify cannot fall between them.
+static void WakeLogThread()
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (s_bLogThreadWaiting.load(std::memory_order_relaxed)) {
+		std::lock_guard<std::mutex> lock(s_logWakeMutex);
+		s_logWake.notify_one();
+	}
+}
+
+// log thread only
+static bool LogRingReady()
+{
+	const LogSlot_t &slot = s_rgLogRing[s_unLogDequeuePos & (k_unLogRingSize - 1)];
+	return slot.unSequence.load(std::memory_order_acquire) == s_unLogDequeuePos + 1;
+}
+
+// any thread; false if the ring was full and the message dropped
+static bool EnqueueLogMessage(const char *pMsgFormat, va_list args)
+{
+	uint32_t unPos = s_unLogEnqueuePos.load(std::memory_order_relaxed);
+	for (;;) {
+		LogSlot_t &slot = s_rgLogRing[unPos & (k_unLogRingSize - 1)];
+		int32_t nDiff = (int32_t)(slot.unSequence.load(std::memory_order_acquire) - unPos);
+		if (nDiff == 0) {
+			if (s_unLogEnqueuePos.compare_exchange_weak(unPos, unPos + 1, std::memory_order_relaxed)) {
+				FormatLogMessage(slot.rchMessage, pMsgFormat, args);
+				slot.unSequence.store(unPos + 1, std::memory_order_release);
+				WakeLogThread();
+				return true;
+			}
+		}
+		else if (nDiff < 0) {
+			// the consumer has not freed this slot yet
+			s_unLogDropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		else {
+			unPos = s_unLogEnqueuePos.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+// log thread only
+static void DrainLogRing()
+{
+	for (;;) {
+		LogSlot_t &slot = s_rgLogRing[s_unLogDequeuePos & (k_unLogRingSize - 1)];
+		if (slot.unSequence.load(std::memory_order_acquire) != s_unLogDequeuePos + 1)
+			break;
+
+		s_pLogFile->Log(slot.rchMessage);
+		slot.unSequence.store(s_unLogDequeuePos + k_unLogRingSize, std::memory_order_release);
+		s_unLogDequeuePos++;
+	}
+
+	uint32_t unDropped = s_unLogDropped.exchange(0, std::memory_order_relaxed);
+	if (unDropped) {
+		char buf[64];
+#if defined( _WIN32 )
+		sprintf_s(buf, "Log overloaded, %u messages dropped\n", unDropped);
+#else
+		snprintf(buf, sizeof(buf), "Log overloaded, %u messages dropped\n", unDropped);
+#endif
+		s_pLogFile->Log(buf);
+	}
+}
+
+static void LogThreadFunction()
+{
+	while (s_bLogThreadRunning) {
+		DrainLogRing();
+
+		std::unique_lock<std::mutex> lock(s_logWakeMutex);
+		s_bLogThreadWaiting.store(true, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		s_logWake.wait_for(lock, std::chrono::milliseconds(k_unLogFallbackFlushMs), [] { return LogRingReady() || !s_bLogThreadRunning; });
+		s_bLogThreadWaiting.store(false, std::memory_order_relaxed);
+	}
+	DrainLogRing();
+}
+
+
+bool InitDriverLog(vr::IVRDriverLog *pDriverLog, bool bAsynchronous)
 {
 	if (s_pLogFile)
 		return false;
 	s_pLogFile = pDriverLog;
+
+	if (s_pLogFile && bAsynchronous) {
+		for (uint32_t i = 0; i < k_unLogRingSize; i++)
+			s_rgLogRing[i].unSequence.store(i, std::memory_order_relaxed);
+		s_unLogEnqueuePos = 0;
+		s_unLogDequeuePos = 0;
+		s_unLogDropped = 0;
+
+		s_bLogThreadRunning = true;
+		s_pLogThread = new std::thread(LogThreadFunction);
+	}
+
 	return s_pLogFile != NULL;
 }
 
 void CleanupDriverLog()
 {
+	if (s_pLogThread) {
+		{
+			std::lock_guard<std::mutex> lock(s_logWakeMutex);
+			s_bLogThreadRunning = false;
+			s_logWake.notify_one();
+		}
+		s_pLogThread->join();
+		delete s_pLogThread;
+		s_pLogThread = NULL;
+	}
 	s_pLogFile = NULL;
 }
 
 static void DriverLogVarArgs(const char *pMsgFormat, va_list args)
 {
-	char buf[1024];
-#if defined( _WIN32 )
-	vsprintf_s(buf, pMsgFormat, args);
-#else
-	vsnprintf(buf, sizeof(buf), pMsgFormat, args);
-#endif
+	if (s_bLogThreadRunning) {
+		EnqueueLogMessage(pMsgFormat, args);
+		return;
+	}
+
+	char buf[k_unLogMessageSize];
+	FormatLogMessage(buf, pMsgFormat, args);
 
 	if (s_pLogFile)
 		s_pLogFile->Log(buf);
 }
 
 
+void SetDriverLogLevel(EDriverLogLevel eLevel)
+{
+	s_nLogLevel = eLevel;
+}
+
+EDriverLogLevel GetDriverLogLevel()
+{
+	return (EDriverLogLevel)s_nLogLevel.load(std::memory_order_relaxed);
+}
+
+bool DriverLogLevelEnabled(EDriverLogLevel eLevel)
+{
+	return eLevel >= s_nLogLevel.load(std::memory_order_relaxed);
+}
+
+const char *DriverLogLevelName(EDriverLogLevel eLevel)
+{
+	if (eLevel < DriverLogLevel_Debug || eLevel > DriverLogLevel_Error)
+		return "unknown";
+	return k_rgchLogLevelNames[eLevel];
+}
+
+bool ParseDriverLogLevel(const char *pchName, EDriverLogLevel *peLevel)
+{
+	for (int i = DriverLogLevel_Debug; i <= DriverLogLevel_Error; i++) {
+		if (!strcmp(pchName, k_rgchLogLevelNames[i])) {
+			*peLevel = (EDriverLogLevel)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+
 void DriverLog(const char *pMsgFormat, ...)
 {
+	if (!DriverLogLevelEnabled(DriverLogLevel_Info))
+		return;
+
+	va_list args;
+	va_start(args, pMsgFormat);
+
+	DriverLogVarArgs(pMsgFormat, args);
+
+	va_end(args);
+}
+
+
+void DriverLogWithLevel(EDriverLogLevel eLevel, const char *pMsgFormat, ...)
+{
+	if (!DriverLogLevelEnabled(eLevel))
+		return;
+
 	va_list args;
 	va_start(args, pMsgFormat);
 
@@ -48,7 +259,10 @@ void DriverLog(const char *pMsgFormat, ...)
 
 void DebugDriverLog(const char *pMsgFormat, ...)
 {
-#ifdef _DEBUG
+#if DRIVERLOG_ENABLE_DEBUG
+	if (!DriverLogLevelEnabled(DriverLogLevel_Debug))
+		return;
+
 	va_list args;
 	va_start(args, pMsgFormat);
 
@@ -58,3 +272,30 @@ void DebugDriverLog(const char *pMsgFormat, ...)
 #endif
 }
 
+
+void RateLimitedDriverLog(DriverLogRateLimit_t *pRateLimit, EDriverLogLevel eLevel, uint32_t unIntervalMs, const char *pMsgFormat, ...)
+{
+	if (!DriverLogLevelEnabled(eLevel))
+		return;
+
+	int64_t nNowMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	if (pRateLimit->nNextLogMs != 0 && nNowMs < pRateLimit->nNextLogMs) {
+		pRateLimit->unSuppressed++;
+		return;
+	}
+	pRateLimit->nNextLogMs = nNowMs + unIntervalMs;
+
+	va_list args;
+	va_start(args, pMsgFormat);
+
+	DriverLogVarArgs(pMsgFormat, args);
+
+	va_end(args);
+
+	uint32_t unSuppressed = pRateLimit->unSuppressed;
+	if (unSuppressed) {
+		pRateLimit->unSuppressed = 0;
+		DriverLogWithLevel(eLevel, "  (suppressed %u times since the last report)\n", unSuppressed);
+	}
+}
+
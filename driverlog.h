@@ -6,10 +6,41 @@
 #pragma once
 
 #include <string>
+#include <stdint.h>
 #include <openvr_driver.h>
 
+// Lines below the runtime threshold are discarded before formatting. Debug
+// lines are also compiled out unless DRIVERLOG_ENABLE_DEBUG is set, which it
+// is by default in _DEBUG builds.
+enum EDriverLogLevel
+{
+	DriverLogLevel_Debug = 0,
+	DriverLogLevel_Info,
+	DriverLogLevel_Warning,
+	DriverLogLevel_Error,
+};
+
+#ifndef DRIVERLOG_ENABLE_DEBUG
+#ifdef _DEBUG
+#define DRIVERLOG_ENABLE_DEBUG 1
+#else
+#define DRIVERLOG_ENABLE_DEBUG 0
+#endif
+#endif
+
+extern void SetDriverLogLevel(EDriverLogLevel eLevel);
+extern EDriverLogLevel GetDriverLogLevel();
+extern bool DriverLogLevelEnabled(EDriverLogLevel eLevel);
+
+// "debug", "info", "warning" or "error"
+extern const char *DriverLogLevelName(EDriverLogLevel eLevel);
+extern bool ParseDriverLogLevel(const char *pchName, EDriverLogLevel *peLevel);
+
+// Info level
 extern void DriverLog(const char *pchFormat, ...);
 
+extern void DriverLogWithLevel(EDriverLogLevel eLevel, const char *pchFormat, ...);
+
 
 // --------------------------------------------------------------------------
 // Purpose: Write to the log file only in debug builds
@@ -17,7 +48,42 @@ extern void DriverLog(const char *pchFormat, ...);
 extern void DebugDriverLog(const char *pchFormat, ...);
 
 
-extern bool InitDriverLog(vr::IVRDriverLog *pDriverLog);
+// --------------------------------------------------------------------------
+// Purpose: Per call site state for DRIVERLOG_RATE_LIMITED. Plain fields so a
+//          function local static is zero initialized without a constructor;
+//          two threads crossing the interval at once may both print.
+// --------------------------------------------------------------------------
+struct DriverLogRateLimit_t
+{
+	int64_t nNextLogMs;
+	uint32_t unSuppressed;
+};
+
+extern void RateLimitedDriverLog(DriverLogRateLimit_t *pRateLimit, EDriverLogLevel eLevel, uint32_t unIntervalMs, const char *pchFormat, ...);
+
+// Log at most once every unIntervalMs from this call site; the next line
+// that gets through is followed by how many were suppressed in between
+#define DRIVERLOG_RATE_LIMITED(eLevel, unIntervalMs, ...) \
+	do { \
+		static DriverLogRateLimit_t s_driverLogRateLimit; \
+		RateLimitedDriverLog(&s_driverLogRateLimit, eLevel, unIntervalMs, __VA_ARGS__); \
+	} while (0)
+
+#if DRIVERLOG_ENABLE_DEBUG
+#define DRIVERLOG_DEBUG(...) DriverLogWithLevel(DriverLogLevel_Debug, __VA_ARGS__)
+#define DRIVERLOG_DEBUG_RATE_LIMITED(unIntervalMs, ...) DRIVERLOG_RATE_LIMITED(DriverLogLevel_Debug, unIntervalMs, __VA_ARGS__)
+#else
+#define DRIVERLOG_DEBUG(...) do { } while (0)
+#define DRIVERLOG_DEBUG_RATE_LIMITED(unIntervalMs, ...) do { } while (0)
+#endif
+
+
+// --------------------------------------------------------------------------
+// Purpose: Start logging to vrserver. In asynchronous mode DriverLog() only
+//          queues the line and a background thread writes it; lines are
+//          dropped rather than blocking the caller if the queue is full.
+// --------------------------------------------------------------------------
+extern bool InitDriverLog(vr::IVRDriverLog *pDriverLog, bool bAsynchronous = false);
 extern void CleanupDriverLog();
 
 
@@ -0,0 +1,156 @@
+#include "glyph_axis_map.h"
+#include "glyph_pose.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if !defined( _WIN32 )
+#include <strings.h>
+#define _strnicmp strncasecmp
+#endif
+
+static const double k_flPi = 3.14159265358979323846;
+
+// the axes a mapping may use, indexed by EGlyphAxis; the sliders are not
+// orientation axes and never take part
+static const char * const k_rgpchAxisNames[] = { "x", "y", "z", "rx", "ry", "rz" };
+static const uint32_t k_unMappableAxes = sizeof(k_rgpchAxisNames) / sizeof(k_rgpchAxisNames[0]);
+
+void GlyphDefaultAxisMapping(GlyphAxisMapping_t *pMapping)
+{
+	pMapping->rgeAxis[GlyphAxisRole_Pitch] = GlyphAxis_Z;
+	pMapping->rgeAxis[GlyphAxisRole_Yaw] = GlyphAxis_RX;
+	pMapping->rgeAxis[GlyphAxisRole_Roll] = GlyphAxis_Y;
+	pMapping->rgbInvert[GlyphAxisRole_Pitch] = false;
+	pMapping->rgbInvert[GlyphAxisRole_Yaw] = false;
+	pMapping->rgbInvert[GlyphAxisRole_Roll] = true;
+	for (int i = 0; i < GlyphAxisRole_Count; i++) {
+		pMapping->rgflOffset[i] = 180.0f;
+	}
+}
+
+bool ParseGlyphAxisMapping(const char *pchAxes, GlyphAxisMapping_t *pMapping)
+{
+	GlyphAxisMapping_t mapping = *pMapping;
+	const char *pch = pchAxes;
+	for (int nRole = 0; nRole < GlyphAxisRole_Count; nRole++) {
+		while (*pch == ' ' || *pch == ',')
+			pch++;
+
+		bool bInvert = false;
+		if (*pch == '-' || *pch == '+') {
+			bInvert = *pch == '-';
+			pch++;
+		}
+
+		size_t unLen = strcspn(pch, " ,");
+		uint32_t unAxis = 0;
+		while (unAxis < k_unMappableAxes && (strlen(k_rgpchAxisNames[unAxis]) != unLen || _strnicmp(pch, k_rgpchAxisNames[unAxis], unLen)))
+			unAxis++;
+		if (unAxis == k_unMappableAxes)
+			return false;
+
+		for (int nOther = 0; nOther < nRole; nOther++) {
+			if (mapping.rgeAxis[nOther] == (EGlyphAxis)unAxis)
+				return false;
+		}
+		mapping.rgeAxis[nRole] = (EGlyphAxis)unAxis;
+		mapping.rgbInvert[nRole] = bInvert;
+		pch += unLen;
+	}
+
+	while (*pch == ' ' || *pch == ',')
+		pch++;
+	if (*pch)
+		return false;
+
+	*pMapping = mapping;
+	return true;
+}
+
+void FormatGlyphAxisMapping(const GlyphAxisMapping_t &mapping, char *pchAxes, uint32_t unAxesLen)
+{
+	const char *rgpchNames[GlyphAxisRole_Count];
+	for (int i = 0; i < GlyphAxisRole_Count; i++) {
+		rgpchNames[i] = (uint32_t)mapping.rgeAxis[i] < k_unMappableAxes ? k_rgpchAxisNames[mapping.rgeAxis[i]] : "?";
+	}
+#if defined( _WIN32 )
+	sprintf_s(pchAxes, unAxesLen, "%s%s %s%s %s%s",
+		mapping.rgbInvert[0] ? "-" : "", rgpchNames[0],
+		mapping.rgbInvert[1] ? "-" : "", rgpchNames[1],
+		mapping.rgbInvert[2] ? "-" : "", rgpchNames[2]);
+#else
+	snprintf(pchAxes, unAxesLen, "%s%s %s%s %s%s",
+		mapping.rgbInvert[0] ? "-" : "", rgpchNames[0],
+		mapping.rgbInvert[1] ? "-" : "", rgpchNames[1],
+		mapping.rgbInvert[2] ? "-" : "", rgpchNames[2]);
+#endif
+}
+
+template <int nPitchAxis, int nYawAxis, int nRollAxis>
+static vr::HmdQuaternion_t GlyphAxisKernel(const GlyphSample_t &sample, const GlyphAxisKernelConstants_t &constants)
+{
+	return HmdQuaternion_FromEulerHalfAngles(
+		constants.rgflScale[GlyphAxisRole_Pitch] * sample.rgnAxis[nPitchAxis] + constants.rgflOffset[GlyphAxisRole_Pitch],
+		constants.rgflScale[GlyphAxisRole_Yaw] * sample.rgnAxis[nYawAxis] + constants.rgflOffset[GlyphAxisRole_Yaw],
+		constants.rgflScale[GlyphAxisRole_Roll] * sample.rgnAxis[nRollAxis] + constants.rgflOffset[GlyphAxisRole_Roll]);
+}
+
+// One kernel for every pitch, yaw and roll axis among the six mappable
+// ones, picked a role at a time. Combinations reusing an axis are never
+// selected, since parsing refuses them, but are cheaper to instantiate than
+// to leave out.
+template <int nPitchAxis, int nYawAxis>
+static GlyphAxisKernel_t GlyphSelectRollKernel(uint32_t unRollAxis)
+{
+	static const GlyphAxisKernel_t k_rgpfnKernels[] =
+	{
+		&GlyphAxisKernel<nPitchAxis, nYawAxis, GlyphAxis_X>,
+		&GlyphAxisKernel<nPitchAxis, nYawAxis, GlyphAxis_Y>,
+		&GlyphAxisKernel<nPitchAxis, nYawAxis, GlyphAxis_Z>,
+		&GlyphAxisKernel<nPitchAxis, nYawAxis, GlyphAxis_RX>,
+		&GlyphAxisKernel<nPitchAxis, nYawAxis, GlyphAxis_RY>,
+		&GlyphAxisKernel<nPitchAxis, nYawAxis, GlyphAxis_RZ>,
+	};
+	return k_rgpfnKernels[unRollAxis];
+}
+
+template <int nPitchAxis>
+static GlyphAxisKernel_t GlyphSelectYawKernel(uint32_t unYawAxis, uint32_t unRollAxis)
+{
+	typedef GlyphAxisKernel_t (*SelectRoll_t)(uint32_t unRollAxis);
+	static const SelectRoll_t k_rgpfnSelect[] =
+	{
+		&GlyphSelectRollKernel<nPitchAxis, GlyphAxis_X>,
+		&GlyphSelectRollKernel<nPitchAxis, GlyphAxis_Y>,
+		&GlyphSelectRollKernel<nPitchAxis, GlyphAxis_Z>,
+		&GlyphSelectRollKernel<nPitchAxis, GlyphAxis_RX>,
+		&GlyphSelectRollKernel<nPitchAxis, GlyphAxis_RY>,
+		&GlyphSelectRollKernel<nPitchAxis, GlyphAxis_RZ>,
+	};
+	return k_rgpfnSelect[unYawAxis](unRollAxis);
+}
+
+GlyphAxisKernel_t GlyphSelectAxisKernel(const GlyphAxisMapping_t &mapping, GlyphAxisKernelConstants_t *pConstants)
+{
+	typedef GlyphAxisKernel_t (*SelectYaw_t)(uint32_t unYawAxis, uint32_t unRollAxis);
+	static const SelectYaw_t k_rgpfnSelect[] =
+	{
+		&GlyphSelectYawKernel<GlyphAxis_X>,
+		&GlyphSelectYawKernel<GlyphAxis_Y>,
+		&GlyphSelectYawKernel<GlyphAxis_Z>,
+		&GlyphSelectYawKernel<GlyphAxis_RX>,
+		&GlyphSelectYawKernel<GlyphAxis_RY>,
+		&GlyphSelectYawKernel<GlyphAxis_RZ>,
+	};
+	static_assert(sizeof(k_rgpfnSelect) / sizeof(k_rgpfnSelect[0]) == k_unMappableAxes, "a kernel row for every mappable axis");
+
+	// the scale and centering GlyphAxesToRotation() uses, per role
+	for (int i = 0; i < GlyphAxisRole_Count; i++) {
+		double flScale = k_flGlyphAxisToHalfAngle;
+		pConstants->rgflScale[i] = mapping.rgbInvert[i] ? -flScale : flScale;
+		pConstants->rgflOffset[i] = 0.5 * mapping.rgflOffset[i] * k_flPi / 180.0;
+	}
+
+	return k_rgpfnSelect[mapping.rgeAxis[GlyphAxisRole_Pitch]](mapping.rgeAxis[GlyphAxisRole_Yaw], mapping.rgeAxis[GlyphAxisRole_Roll]);
+}
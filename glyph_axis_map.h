@@ -0,0 +1,69 @@
+#ifndef GLYPH_AXIS_MAP_H
+#define GLYPH_AXIS_MAP_H
+
+#pragma once
+
+#include "glyph_sample.h"
+
+#include <openvr_driver.h>
+
+#include <stdint.h>
+
+enum EGlyphAxisRole
+{
+	GlyphAxisRole_Pitch = 0,
+	GlyphAxisRole_Yaw,
+	GlyphAxisRole_Roll,
+
+	GlyphAxisRole_Count
+};
+
+// --------------------------------------------------------------------------
+// Purpose: Which tracker axis drives pitch, yaw and roll, and how. Each
+//          angle is sign * axis * 360 / 65535 + offset degrees, so a full
+//          turn spans the 0..65535 range of the axis. The Glyph reports
+//          pitch on lZ, yaw on lRx and roll on -lY, and the middle of each
+//          range faces forward.
+// --------------------------------------------------------------------------
+struct GlyphAxisMapping_t
+{
+	EGlyphAxis rgeAxis[GlyphAxisRole_Count];	// one of X..RZ each, all different
+	bool rgbInvert[GlyphAxisRole_Count];
+	float rgflOffset[GlyphAxisRole_Count];		// degrees
+};
+
+extern void GlyphDefaultAxisMapping(GlyphAxisMapping_t *pMapping);
+
+// Parses the axes of a mapping from "z rx -y": the pitch, yaw and roll axes
+// among x, y, z, rx, ry and rz, each inverted by a leading '-'. Offsets are
+// left alone. Returns false, leaving pMapping untouched, on anything else.
+extern bool ParseGlyphAxisMapping(const char *pchAxes, GlyphAxisMapping_t *pMapping);
+
+// the axes in the form ParseGlyphAxisMapping() reads
+extern void FormatGlyphAxisMapping(const GlyphAxisMapping_t &mapping, char *pchAxes, uint32_t unAxesLen);
+
+// --------------------------------------------------------------------------
+// Purpose: Head rotation from one sample, as a kernel compiled for a single
+//          choice of axes. Signs and offsets are folded into per-role
+//          half-angle constants, so a call is three loads, three
+//          multiply-adds and the Euler conversion, with no branches or axis
+//          lookups. Select once, then call per sample. This is what makes
+//          the axes configurable, not a speedup: the call through the
+//          pointer cannot be inlined, and for the default axes it runs a
+//          few ns slower than the inline GlyphAxesToRotation() (glyph_bench).
+// --------------------------------------------------------------------------
+struct GlyphAxisKernelConstants_t
+{
+	double rgflScale[GlyphAxisRole_Count];		// half angle per axis count, signed
+	double rgflOffset[GlyphAxisRole_Count];		// half angle
+};
+
+typedef vr::HmdQuaternion_t (*GlyphAxisKernel_t)(const GlyphSample_t &sample, const GlyphAxisKernelConstants_t &constants);
+
+// the kernel for the mapping's axes and the constants to call it with;
+// the mapping must have passed through ParseGlyphAxisMapping() or
+// GlyphDefaultAxisMapping()
+extern GlyphAxisKernel_t GlyphSelectAxisKernel(const GlyphAxisMapping_t &mapping, GlyphAxisKernelConstants_t *pConstants);
+
+
+#endif // GLYPH_AXIS_MAP_H
@@ -0,0 +1,60 @@
+#include "glyph_debug.h"
+
+#include <stdio.h>
+#include <stdarg.h>
+
+CGlyphDebugResponse::CGlyphDebugResponse(char *pchBuffer, uint32_t unBufferSize)
+	: m_pchBuffer(pchBuffer)
+	, m_unBufferSize(unBufferSize)
+	, m_unLength(0)
+	, m_bTruncated(false)
+{
+	if (m_unBufferSize >= 1)
+		m_pchBuffer[0] = 0;
+}
+
+void CGlyphDebugResponse::Printf(const char *pchFormat, ...)
+{
+	if (m_unLength + 1 >= m_unBufferSize) {
+		m_bTruncated = true;
+		return;
+	}
+
+	uint32_t unRemaining = m_unBufferSize - m_unLength;
+
+	va_list args;
+	va_start(args, pchFormat);
+#if defined( _WIN32 )
+	int nWritten = vsnprintf_s(m_pchBuffer + m_unLength, unRemaining, _TRUNCATE, pchFormat, args);
+#else
+	int nWritten = vsnprintf(m_pchBuffer + m_unLength, unRemaining, pchFormat, args);
+#endif
+	va_end(args);
+
+	// a truncated write has filled the buffer and been terminated
+	if (nWritten < 0 || (uint32_t)nWritten >= unRemaining) {
+		m_unLength = m_unBufferSize - 1;
+		m_bTruncated = true;
+		return;
+	}
+	m_unLength += nWritten;
+}
+
+const char *GlyphNextDebugWord(const char *pchRequest, char *pchWord, uint32_t unWordSize)
+{
+	while (*pchRequest == ' ')
+		pchRequest++;
+
+	uint32_t unLength = 0;
+	while (*pchRequest && *pchRequest != ' ') {
+		if (unLength + 1 < unWordSize)
+			pchWord[unLength++] = *pchRequest;
+		pchRequest++;
+	}
+	if (unWordSize >= 1)
+		pchWord[unLength] = 0;
+
+	while (*pchRequest == ' ')
+		pchRequest++;
+	return pchRequest;
+}
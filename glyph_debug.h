@@ -0,0 +1,37 @@
+#ifndef GLYPH_DEBUG_H
+#define GLYPH_DEBUG_H
+
+#pragma once
+
+#include <stdint.h>
+
+// --------------------------------------------------------------------------
+// Purpose: Builds the text reply to an OpenVR driver debug request in the
+//          caller's buffer. Output past the end of the buffer is dropped and
+//          the reply is always terminated.
+// --------------------------------------------------------------------------
+class CGlyphDebugResponse
+{
+public:
+	CGlyphDebugResponse(char *pchBuffer, uint32_t unBufferSize);
+
+	void Printf(const char *pchFormat, ...);
+
+	bool IsTruncated() const { return m_bTruncated; }
+
+private:
+	char *m_pchBuffer;
+	uint32_t m_unBufferSize;
+	uint32_t m_unLength;
+	bool m_bTruncated;
+};
+
+// --------------------------------------------------------------------------
+// Purpose: Splits the first space separated word off a debug request.
+//          Copies it to pchWord and returns the rest with leading spaces
+//          skipped.
+// --------------------------------------------------------------------------
+extern const char *GlyphNextDebugWord(const char *pchRequest, char *pchWord, uint32_t unWordSize);
+
+
+#endif // GLYPH_DEBUG_H
@@ -0,0 +1,32 @@
+#ifndef GLYPH_DISPLAY_H
+#define GLYPH_DISPLAY_H
+
+#pragma once
+
+#include <stdint.h>
+
+// --------------------------------------------------------------------------
+// Purpose: Where the Glyph's panel sits on the desktop and how it is driven
+// --------------------------------------------------------------------------
+struct GlyphDisplayInfo_t
+{
+	int32_t nX;
+	int32_t nY;
+	uint32_t unWidth;
+	uint32_t unHeight;
+	uint32_t unBitsPerPixel;
+	float flFrequency;
+	char rchAdapter[32];		// OS name of the output, e.g. \\.\DISPLAY2 or an XRandR output such as DP-1
+};
+
+// --------------------------------------------------------------------------
+// Purpose: Locate Glyph display unIndex, counting Glyph displays in
+//          enumeration order. The output it was last found on is remembered
+//          in the driver settings and checked first; all outputs are
+//          enumerated only when that fails. Returns false if that display is
+//          not connected.
+// --------------------------------------------------------------------------
+extern bool GlyphFindDisplay(uint32_t unIndex, GlyphDisplayInfo_t *pDisplay);
+
+
+#endif // GLYPH_DISPLAY_H
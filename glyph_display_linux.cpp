@@ -0,0 +1,246 @@
+#include "glyph_display.h"
+#include "glyph_settings.h"
+#include "glyph_time.h"
+#include "driverlog.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#if GLYPH_HAVE_XRANDR
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include <X11/extensions/Xrandr.h>
+#endif
+
+#if GLYPH_HAVE_DRM
+#include <xf86drm.h>
+#include <xf86drmMode.h>
+#endif
+
+#if GLYPH_HAVE_XRANDR || GLYPH_HAVE_DRM
+// EDID manufacturer and product of the Glyph's display, as in its MONITOR\AVG0065 id
+static const char k_rgchGlyphManufacturer[] = "AVG";
+static const uint16_t k_unGlyphMonitorProduct = 0x0065;
+
+// The EDID base block carries the manufacturer as three 5-bit letters in
+// bytes 8-9, big endian, and the product code in bytes 10-11, little endian
+static bool IsGlyphEdid(const uint8_t *pEdid, size_t unLength)
+{
+	if (unLength < 12)
+		return false;
+
+	uint16_t unManufacturer = (uint16_t)((pEdid[8] << 8) | pEdid[9]);
+	char rchManufacturer[4];
+	rchManufacturer[0] = (char)('A' - 1 + ((unManufacturer >> 10) & 0x1f));
+	rchManufacturer[1] = (char)('A' - 1 + ((unManufacturer >> 5) & 0x1f));
+	rchManufacturer[2] = (char)('A' - 1 + (unManufacturer & 0x1f));
+	rchManufacturer[3] = 0;
+
+	uint16_t unProduct = (uint16_t)(pEdid[10] | (pEdid[11] << 8));
+	return !strcmp(rchManufacturer, k_rgchGlyphManufacturer) && unProduct == k_unGlyphMonitorProduct;
+}
+#endif
+
+#if GLYPH_HAVE_XRANDR
+// Search the X server's outputs; with pchOutput set, check only that output
+// and ignore unIndex
+static bool FindXRandRDisplay(uint32_t unIndex, const char *pchOutput, GlyphDisplayInfo_t *pDisplay, bool *pbSearched)
+{
+	Display *pX = XOpenDisplay(NULL);
+	if (!pX)
+		return false;
+
+	*pbSearched = true;
+	bool bFound = false;
+	Window root = DefaultRootWindow(pX);
+	XRRScreenResources *pResources = XRRGetScreenResourcesCurrent(pX, root);
+	Atom edidAtom = XInternAtom(pX, RR_PROPERTY_RANDR_EDID, True);
+
+	for (int i = 0; pResources && edidAtom != None && !bFound && i < pResources->noutput; i++) {
+		XRROutputInfo *pOutput = XRRGetOutputInfo(pX, pResources, pResources->outputs[i]);
+		if (!pOutput)
+			continue;
+
+		DRIVERLOG_DEBUG("Display Name: %s\n", pOutput->name);
+		if (pOutput->connection != RR_Connected || !pOutput->crtc || (pchOutput && strcmp(pchOutput, pOutput->name))) {
+			XRRFreeOutputInfo(pOutput);
+			continue;
+		}
+
+		unsigned char *pEdid = NULL;
+		Atom actualType;
+		int nActualFormat;
+		unsigned long ulItems, ulBytesAfter;
+		bool bGlyph = XRRGetOutputProperty(pX, pResources->outputs[i], edidAtom, 0, 32, False, False, AnyPropertyType,
+			&actualType, &nActualFormat, &ulItems, &ulBytesAfter, &pEdid) == Success && nActualFormat == 8 && IsGlyphEdid(pEdid, ulItems);
+		if (pEdid)
+			XFree(pEdid);
+
+		if (bGlyph && (pchOutput || unIndex-- == 0)) {
+			XRRCrtcInfo *pCrtc = XRRGetCrtcInfo(pX, pResources, pOutput->crtc);
+			if (pCrtc) {
+				pDisplay->nX = pCrtc->x;
+				pDisplay->nY = pCrtc->y;
+				pDisplay->unWidth = pCrtc->width;
+				pDisplay->unHeight = pCrtc->height;
+				pDisplay->unBitsPerPixel = (uint32_t)DefaultDepth(pX, DefaultScreen(pX));
+				pDisplay->flFrequency = 0.0f;
+				for (int j = 0; j < pResources->nmode; j++) {
+					const XRRModeInfo &mode = pResources->modes[j];
+					if (mode.id == pCrtc->mode && mode.hTotal && mode.vTotal)
+						pDisplay->flFrequency = (float)((double)mode.dotClock / ((double)mode.hTotal * mode.vTotal));
+				}
+				snprintf(pDisplay->rchAdapter, sizeof(pDisplay->rchAdapter), "%s", pOutput->name);
+				XRRFreeCrtcInfo(pCrtc);
+				bFound = true;
+			}
+		}
+		XRRFreeOutputInfo(pOutput);
+	}
+
+	if (pResources)
+		XRRFreeScreenResources(pResources);
+	XCloseDisplay(pX);
+	return bFound;
+}
+#endif
+
+#if GLYPH_HAVE_DRM
+// DRM nodes tried when no X server is reachable
+static const int k_nMaxDrmCards = 16;
+
+static bool ReadDrmConnectorEdid(int nFd, const drmModeConnector *pConnector)
+{
+	bool bGlyph = false;
+	for (int i = 0; !bGlyph && i < pConnector->count_props; i++) {
+		drmModePropertyPtr pProperty = drmModeGetProperty(nFd, pConnector->props[i]);
+		if (!pProperty)
+			continue;
+
+		if (!strcmp(pProperty->name, "EDID")) {
+			drmModePropertyBlobPtr pBlob = drmModeGetPropertyBlob(nFd, (uint32_t)pConnector->prop_values[i]);
+			if (pBlob) {
+				bGlyph = IsGlyphEdid((const uint8_t *)pBlob->data, pBlob->length);
+				drmModeFreePropertyBlob(pBlob);
+			}
+		}
+		drmModeFreeProperty(pProperty);
+	}
+	return bGlyph;
+}
+
+// Read the mode the connector's CRTC is scanning out
+static bool ReadDrmMode(int nFd, const drmModeConnector *pConnector, GlyphDisplayInfo_t *pDisplay)
+{
+	drmModeEncoderPtr pEncoder = pConnector->encoder_id ? drmModeGetEncoder(nFd, pConnector->encoder_id) : NULL;
+	if (!pEncoder)
+		return false;
+
+	drmModeCrtcPtr pCrtc = pEncoder->crtc_id ? drmModeGetCrtc(nFd, pEncoder->crtc_id) : NULL;
+	drmModeFreeEncoder(pEncoder);
+	if (!pCrtc)
+		return false;
+
+	bool bValid = pCrtc->mode_valid != 0;
+	if (bValid) {
+		pDisplay->nX = (int32_t)pCrtc->x;
+		pDisplay->nY = (int32_t)pCrtc->y;
+		pDisplay->unWidth = pCrtc->mode.hdisplay;
+		pDisplay->unHeight = pCrtc->mode.vdisplay;
+		pDisplay->unBitsPerPixel = 32;
+		pDisplay->flFrequency = pCrtc->mode.htotal && pCrtc->mode.vtotal
+			? (float)(1000.0 * pCrtc->mode.clock / ((double)pCrtc->mode.htotal * pCrtc->mode.vtotal))
+			: (float)pCrtc->mode.vrefresh;
+	}
+	drmModeFreeCrtc(pCrtc);
+	return bValid;
+}
+
+// Search every card's connectors, named e.g. card0-71 by card and connector
+// id; with pchOutput set, check only that connector and ignore unIndex
+static bool FindDrmDisplay(uint32_t unIndex, const char *pchOutput, GlyphDisplayInfo_t *pDisplay)
+{
+	bool bFound = false;
+	for (int nCard = 0; !bFound && nCard < k_nMaxDrmCards; nCard++) {
+		char rchPath[32];
+		snprintf(rchPath, sizeof(rchPath), "/dev/dri/card%d", nCard);
+		int nFd = open(rchPath, O_RDWR | O_CLOEXEC);
+		if (nFd < 0)
+			continue;
+
+		drmModeResPtr pResources = drmModeGetResources(nFd);
+		for (int i = 0; pResources && !bFound && i < pResources->count_connectors; i++) {
+			char rchName[32];
+			snprintf(rchName, sizeof(rchName), "card%d-%u", nCard, pResources->connectors[i]);
+			if (pchOutput && strcmp(pchOutput, rchName))
+				continue;
+
+			drmModeConnectorPtr pConnector = drmModeGetConnector(nFd, pResources->connectors[i]);
+			if (!pConnector)
+				continue;
+
+			DRIVERLOG_DEBUG("Display Name: %s\n", rchName);
+			if (pConnector->connection == DRM_MODE_CONNECTED && ReadDrmConnectorEdid(nFd, pConnector) && (pchOutput || unIndex-- == 0)) {
+				bFound = ReadDrmMode(nFd, pConnector, pDisplay);
+				if (bFound)
+					snprintf(pDisplay->rchAdapter, sizeof(pDisplay->rchAdapter), "%s", rchName);
+			}
+			drmModeFreeConnector(pConnector);
+		}
+
+		if (pResources)
+			drmModeFreeResources(pResources);
+		close(nFd);
+	}
+	return bFound;
+}
+#endif
+
+// XRandR has the desktop position SteamVR lays the window out on; DRM alone
+// is used when there is no X server, e.g. with direct mode on a bare console
+static bool FindDisplay(uint32_t unIndex, const char *pchOutput, GlyphDisplayInfo_t *pDisplay)
+{
+	bool bSearched = false;
+#if GLYPH_HAVE_XRANDR
+	if (FindXRandRDisplay(unIndex, pchOutput, pDisplay, &bSearched))
+		return true;
+#endif
+#if GLYPH_HAVE_DRM
+	if (!bSearched)
+		return FindDrmDisplay(unIndex, pchOutput, pDisplay);
+#endif
+	(void)unIndex;
+	(void)pchOutput;
+	(void)pDisplay;
+	(void)bSearched;
+	return false;
+}
+
+bool GlyphFindDisplay(uint32_t unIndex, GlyphDisplayInfo_t *pDisplay)
+{
+	int64_t nStart = GlyphTicksNow();
+
+	char rchAdapterKey[64];
+	GlyphIndexedSettingKey(k_pch_Glyph_DisplayAdapter_String, unIndex, rchAdapterKey, sizeof(rchAdapterKey));
+
+	char rchAdapter[32];
+	GlyphSettingString(rchAdapterKey, rchAdapter, sizeof(rchAdapter), "");
+	if (rchAdapter[0]) {
+		if (FindDisplay(unIndex, rchAdapter, pDisplay)) {
+			DriverLog("Glyph display found on cached output %s in %.2f ms\n", pDisplay->rchAdapter, 1000.0 * GlyphTicksToSeconds(GlyphTicksNow() - nStart));
+			return true;
+		}
+		DriverLog("Glyph display is no longer on %s, searching all displays\n", rchAdapter);
+	}
+
+	if (!FindDisplay(unIndex, NULL, pDisplay)) {
+		DriverLog("No Glyph display found after %.2f ms\n", 1000.0 * GlyphTicksToSeconds(GlyphTicksNow() - nStart));
+		return false;
+	}
+
+	vr::VRSettings()->SetString(k_pch_Glyph_Section, rchAdapterKey, pDisplay->rchAdapter);
+	DriverLog("Glyph display found on %s by full enumeration in %.2f ms\n", pDisplay->rchAdapter, 1000.0 * GlyphTicksToSeconds(GlyphTicksNow() - nStart));
+	return true;
+}
@@ -0,0 +1,120 @@
+#include "glyph_display.h"
+#include "glyph_settings.h"
+#include "glyph_time.h"
+#include "driverlog.h"
+
+#include <windows.h>
+
+// EDID manufacturer and product of the Glyph's display
+static const char k_rgchGlyphMonitorId[] = "MONITOR\\AVG0065";
+
+static bool IsGlyphMonitor(const DISPLAY_DEVICEA &monitor)
+{
+	return !strncmp(k_rgchGlyphMonitorId, monitor.DeviceID, sizeof(k_rgchGlyphMonitorId) - 1);
+}
+
+// Read the current mode of an output known to drive the Glyph
+static bool ReadDisplayMode(const char *pchAdapter, GlyphDisplayInfo_t *pDisplay)
+{
+	DEVMODEA deviceSettings = { 0 };
+	deviceSettings.dmSize = sizeof(DEVMODEA);
+
+	if (EnumDisplaySettingsExA(pchAdapter, ENUM_CURRENT_SETTINGS, &deviceSettings, 0) == 0) {
+		DriverLog("Display Info Error: %i\n", GetLastError());
+		return false;
+	}
+
+	pDisplay->nX = deviceSettings.dmPosition.x;
+	pDisplay->nY = deviceSettings.dmPosition.y;
+	pDisplay->unWidth = deviceSettings.dmPelsWidth;
+	pDisplay->unHeight = deviceSettings.dmPelsHeight;
+	pDisplay->unBitsPerPixel = deviceSettings.dmBitsPerPel;
+	pDisplay->flFrequency = (float)deviceSettings.dmDisplayFrequency;
+	strcpy_s(pDisplay->rchAdapter, pchAdapter);
+
+#if DRIVERLOG_ENABLE_DEBUG
+	POINT point = { deviceSettings.dmPosition.x, deviceSettings.dmPosition.y };
+	MONITORINFOEXA monInfo = { 0 };
+	monInfo.cbSize = sizeof(MONITORINFOEXA);
+	if (GetMonitorInfoA(MonitorFromPoint(point, MONITOR_DEFAULTTONEAREST), &monInfo)) {
+		DRIVERLOG_DEBUG("Monitor Rect: %ld, %ld, %ld, %ld\n", monInfo.rcMonitor.left, monInfo.rcMonitor.right, monInfo.rcMonitor.top, monInfo.rcMonitor.bottom);
+	}
+#endif
+	return true;
+}
+
+// Check the output remembered from the last run without enumerating the rest
+static bool ValidateCachedDisplay(uint32_t unIndex, GlyphDisplayInfo_t *pDisplay)
+{
+	char rchAdapterKey[64], rchMonitorKey[64];
+	GlyphIndexedSettingKey(k_pch_Glyph_DisplayAdapter_String, unIndex, rchAdapterKey, sizeof(rchAdapterKey));
+	GlyphIndexedSettingKey(k_pch_Glyph_DisplayMonitor_Int32, unIndex, rchMonitorKey, sizeof(rchMonitorKey));
+
+	char rchAdapter[32];
+	GlyphSettingString(rchAdapterKey, rchAdapter, sizeof(rchAdapter), "");
+	int32_t nMonitor = GlyphSettingInt32(rchMonitorKey, -1);
+	if (!rchAdapter[0] || nMonitor < 0)
+		return false;
+
+	DISPLAY_DEVICEA monitor = { 0 };
+	monitor.cb = sizeof(DISPLAY_DEVICEA);
+	if (EnumDisplayDevicesA(rchAdapter, (DWORD)nMonitor, &monitor, 0) == 0 || !IsGlyphMonitor(monitor)) {
+		DriverLog("Glyph display is no longer on %s, searching all displays\n", rchAdapter);
+		return false;
+	}
+
+	return ReadDisplayMode(rchAdapter, pDisplay);
+}
+
+// Walk every adapter output and every monitor on it, skipping the first
+// unIndex Glyph displays
+static bool EnumerateDisplays(uint32_t unIndex, GlyphDisplayInfo_t *pDisplay, DWORD *pdwMonitor)
+{
+	DISPLAY_DEVICEA adapter = { 0 };
+	adapter.cb = sizeof(DISPLAY_DEVICEA);
+
+	for (DWORD deviceIndex = 0; EnumDisplayDevicesA(NULL, deviceIndex, &adapter, 0) != 0; deviceIndex++) {
+		DRIVERLOG_DEBUG("Device String: %s\n", adapter.DeviceString);
+		DRIVERLOG_DEBUG("Device Name: %s\n", adapter.DeviceName);
+
+		DISPLAY_DEVICEA monitor = { 0 };
+		monitor.cb = sizeof(DISPLAY_DEVICEA);
+
+		for (DWORD displayIndex = 0; EnumDisplayDevicesA(adapter.DeviceName, displayIndex, &monitor, 0) != 0; displayIndex++) {
+			DRIVERLOG_DEBUG("Display ID: %s\n", monitor.DeviceID);
+			DRIVERLOG_DEBUG("Display Name: %s\n\n", monitor.DeviceName);
+
+			if (IsGlyphMonitor(monitor) && unIndex-- == 0) {
+				DriverLog("Display Device Found on %s\n", adapter.DeviceName);
+				*pdwMonitor = displayIndex;
+				return ReadDisplayMode(adapter.DeviceName, pDisplay);
+			}
+		}
+	}
+
+	return false;
+}
+
+bool GlyphFindDisplay(uint32_t unIndex, GlyphDisplayInfo_t *pDisplay)
+{
+	int64_t nStart = GlyphTicksNow();
+
+	if (ValidateCachedDisplay(unIndex, pDisplay)) {
+		DriverLog("Glyph display found on cached output %s in %.2f ms\n", pDisplay->rchAdapter, 1000.0 * GlyphTicksToSeconds(GlyphTicksNow() - nStart));
+		return true;
+	}
+
+	DWORD dwMonitor = 0;
+	if (!EnumerateDisplays(unIndex, pDisplay, &dwMonitor)) {
+		DriverLog("No Glyph display found after %.2f ms\n", 1000.0 * GlyphTicksToSeconds(GlyphTicksNow() - nStart));
+		return false;
+	}
+
+	char rchAdapterKey[64], rchMonitorKey[64];
+	GlyphIndexedSettingKey(k_pch_Glyph_DisplayAdapter_String, unIndex, rchAdapterKey, sizeof(rchAdapterKey));
+	GlyphIndexedSettingKey(k_pch_Glyph_DisplayMonitor_Int32, unIndex, rchMonitorKey, sizeof(rchMonitorKey));
+	vr::VRSettings()->SetString(k_pch_Glyph_Section, rchAdapterKey, pDisplay->rchAdapter);
+	vr::VRSettings()->SetInt32(k_pch_Glyph_Section, rchMonitorKey, (int32_t)dwMonitor);
+	DriverLog("Glyph display found on %s by full enumeration in %.2f ms\n", pDisplay->rchAdapter, 1000.0 * GlyphTicksToSeconds(GlyphTicksNow() - nStart));
+	return true;
+}
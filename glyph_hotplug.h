@@ -0,0 +1,104 @@
+#ifndef GLYPH_HOTPLUG_H
+#define GLYPH_HOTPLUG_H
+
+#pragma once
+
+#include "glyph_time.h"
+#include "glyph_wait.h"
+
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+
+// --------------------------------------------------------------------------
+// Purpose: Retry schedule for reopening a device that is not there. The
+//          first attempt is immediate, then the delay doubles after every
+//          failure up to the maximum.
+// --------------------------------------------------------------------------
+class CGlyphBackoff
+{
+public:
+	CGlyphBackoff(double flInitialDelay, double flMaxDelay)
+		: m_nInitialDelay(GlyphSecondsToTicks(flInitialDelay))
+		, m_nMaxDelay(GlyphSecondsToTicks(flMaxDelay))
+	{
+		Reset();
+	}
+
+	// the next attempt is due immediately
+	void Reset()
+	{
+		m_nDelay = m_nInitialDelay;
+		m_nNextAttempt = 0;
+	}
+
+	bool IsDue(int64_t nNow) const { return nNow >= m_nNextAttempt; }
+
+	void OnFailure(int64_t nNow)
+	{
+		m_nNextAttempt = nNow + m_nDelay;
+		m_nDelay = m_nDelay * 2 < m_nMaxDelay ? m_nDelay * 2 : m_nMaxDelay;
+	}
+
+	int64_t TicksUntilDue(int64_t nNow) const { return m_nNextAttempt > nNow ? m_nNextAttempt - nNow : 0; }
+
+private:
+	int64_t m_nInitialDelay;
+	int64_t m_nMaxDelay;
+	int64_t m_nDelay;
+	int64_t m_nNextAttempt;
+};
+
+// --------------------------------------------------------------------------
+// Purpose: Watches for HID devices coming and going and for display mode
+//          changes, on its own thread: a hidden window on Windows, a kernel
+//          uevent socket on Linux. It only counts the notifications and
+//          signals the wake event; whoever owns the devices compares the
+//          counts and reopens them on its own thread.
+// --------------------------------------------------------------------------
+class CGlyphDeviceWatcher
+{
+public:
+	CGlyphDeviceWatcher();
+	~CGlyphDeviceWatcher();
+
+	bool Start();
+	void Stop();
+
+	// Signalled after either count changes; GLYPH_NO_WAIT_HANDLE while
+	// stopped. An auto reset event on Windows; on Linux an eventfd the
+	// waiter reads to reset.
+	GlyphWaitHandle_t GetWakeEvent() const { return m_hWakeEvent; }
+
+	uint32_t GetDeviceChangeCount() const { return m_unDeviceChanges.load(std::memory_order_relaxed); }
+	uint32_t GetDisplayChangeCount() const { return m_unDisplayChanges.load(std::memory_order_relaxed); }
+
+private:
+	void Notify(std::atomic<uint32_t> &unCount);
+
+#if defined( _WINDOWS )
+	void WatcherThread(HANDLE hReady);
+	static LRESULT CALLBACK staticWindowProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
+#else
+	void WatcherThread();
+	void HandleUevent(const char *pchMessage, size_t unLength);
+#endif
+
+	std::thread *m_pThread;
+	GlyphWaitHandle_t m_hWakeEvent;
+#if defined( _WINDOWS )
+	HWND m_hWindow;		// set by the watcher thread before it signals hReady
+#else
+	int m_nUeventSocket;
+	int m_nStopFd;		// eventfd, written once to end the thread
+#endif
+
+	std::atomic<uint32_t> m_unDeviceChanges;
+	std::atomic<uint32_t> m_unDisplayChanges;
+
+	CGlyphDeviceWatcher(const CGlyphDeviceWatcher &);
+	CGlyphDeviceWatcher &operator=(const CGlyphDeviceWatcher &);
+};
+
+
+#endif // GLYPH_HOTPLUG_H
@@ -0,0 +1,148 @@
+#include "glyph_hotplug.h"
+#include "driverlog.h"
+
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <linux/netlink.h>
+
+// kernel uevents are a few hundred bytes; this holds the largest with room to spare
+static const size_t k_unUeventBufferSize = 8192;
+
+CGlyphDeviceWatcher::CGlyphDeviceWatcher()
+	: m_pThread(NULL)
+	, m_hWakeEvent(GLYPH_NO_WAIT_HANDLE)
+	, m_nUeventSocket(-1)
+	, m_nStopFd(-1)
+	, m_unDeviceChanges(0)
+	, m_unDisplayChanges(0)
+{
+}
+
+CGlyphDeviceWatcher::~CGlyphDeviceWatcher()
+{
+	Stop();
+}
+
+bool CGlyphDeviceWatcher::Start()
+{
+	if (m_pThread)
+		return true;
+
+	m_hWakeEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	m_nStopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (m_hWakeEvent < 0 || m_nStopFd < 0) {
+		DriverLog("Unable to create device watcher events: %i\n", errno);
+		Stop();
+		return false;
+	}
+
+	// The kernel's own broadcast, so no udev daemon or library is needed.
+	// It arrives before udev has set up the device node; the owner's retry
+	// schedule covers the gap.
+	m_nUeventSocket = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+	if (m_nUeventSocket < 0) {
+		DriverLog("Unable to open uevent socket: %i\n", errno);
+		Stop();
+		return false;
+	}
+
+	struct sockaddr_nl address;
+	memset(&address, 0, sizeof(address));
+	address.nl_family = AF_NETLINK;
+	address.nl_groups = 1;
+	if (bind(m_nUeventSocket, (struct sockaddr *)&address, sizeof(address)) < 0) {
+		DriverLog("Unable to register for device notifications: %i\n", errno);
+		Stop();
+		return false;
+	}
+
+	m_pThread = new std::thread(&CGlyphDeviceWatcher::WatcherThread, this);
+	return true;
+}
+
+void CGlyphDeviceWatcher::Stop()
+{
+	if (m_pThread) {
+		eventfd_write(m_nStopFd, 1);
+		m_pThread->join();
+		delete m_pThread;
+		m_pThread = NULL;
+	}
+	if (m_nUeventSocket >= 0) {
+		close(m_nUeventSocket);
+		m_nUeventSocket = -1;
+	}
+	if (m_nStopFd >= 0) {
+		close(m_nStopFd);
+		m_nStopFd = -1;
+	}
+	if (m_hWakeEvent != GLYPH_NO_WAIT_HANDLE) {
+		close(m_hWakeEvent);
+		m_hWakeEvent = GLYPH_NO_WAIT_HANDLE;
+	}
+}
+
+void CGlyphDeviceWatcher::Notify(std::atomic<uint32_t> &unCount)
+{
+	unCount.fetch_add(1, std::memory_order_relaxed);
+	eventfd_write(m_hWakeEvent, 1);
+}
+
+void CGlyphDeviceWatcher::WatcherThread()
+{
+	char rchMessage[k_unUeventBufferSize];
+	struct pollfd rgFds[2];
+	rgFds[0].fd = m_nStopFd;
+	rgFds[0].events = POLLIN;
+	rgFds[1].fd = m_nUeventSocket;
+	rgFds[1].events = POLLIN;
+
+	for (;;) {
+		if (poll(rgFds, 2, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			DriverLog("Device watcher stopped: %i\n", errno);
+			return;
+		}
+		if (rgFds[0].revents)
+			return;
+
+		ssize_t nLength = recv(m_nUeventSocket, rchMessage, sizeof(rchMessage) - 1, 0);
+		if (nLength > 0) {
+			rchMessage[nLength] = 0;
+			HandleUevent(rchMessage, (size_t)nLength);
+		}
+	}
+}
+
+// A uevent is "ACTION@DEVPATH" followed by NUL separated KEY=VALUE pairs.
+// evdev and hidraw nodes coming and going are device changes; the DRM
+// subsystem reports connector hotplug and mode changes as "change".
+void CGlyphDeviceWatcher::HandleUevent(const char *pchMessage, size_t unLength)
+{
+	const char *pchAction = NULL;
+	const char *pchSubsystem = NULL;
+	for (size_t i = 0; i < unLength; i += strlen(pchMessage + i) + 1) {
+		const char *pchField = pchMessage + i;
+		if (!strncmp(pchField, "ACTION=", 7))
+			pchAction = pchField + 7;
+		else if (!strncmp(pchField, "SUBSYSTEM=", 10))
+			pchSubsystem = pchField + 10;
+	}
+	if (!pchAction || !pchSubsystem)
+		return;
+
+	bool bArrivalOrRemoval = !strcmp(pchAction, "add") || !strcmp(pchAction, "remove");
+	if (bArrivalOrRemoval && (!strcmp(pchSubsystem, "input") || !strcmp(pchSubsystem, "hidraw"))) {
+		DRIVERLOG_DEBUG("%s device %s\n", pchSubsystem, !strcmp(pchAction, "add") ? "arrived" : "removed");
+		Notify(m_unDeviceChanges);
+	}
+	else if (!strcmp(pchSubsystem, "drm") && !strcmp(pchAction, "change")) {
+		DRIVERLOG_DEBUG("Display configuration changed\n");
+		Notify(m_unDisplayChanges);
+	}
+}
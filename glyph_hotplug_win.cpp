@@ -0,0 +1,154 @@
+#include "glyph_hotplug.h"
+#include "driverlog.h"
+
+#include <windows.h>
+#include <Dbt.h>
+#include <hidsdi.h>
+
+static const char k_rchWatcherWindowClass[] = "GlyphDeviceWatcher";
+
+CGlyphDeviceWatcher::CGlyphDeviceWatcher()
+	: m_pThread(NULL)
+	, m_hWakeEvent(NULL)
+	, m_hWindow(NULL)
+	, m_unDeviceChanges(0)
+	, m_unDisplayChanges(0)
+{
+}
+
+CGlyphDeviceWatcher::~CGlyphDeviceWatcher()
+{
+	Stop();
+}
+
+bool CGlyphDeviceWatcher::Start()
+{
+	if (m_pThread)
+		return true;
+
+	m_hWakeEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+	HANDLE hReady = CreateEvent(NULL, TRUE, FALSE, NULL);
+	if (!m_hWakeEvent || !hReady) {
+		DriverLog("Unable to create device watcher events: %i\n", GetLastError());
+		if (hReady)
+			CloseHandle(hReady);
+		Stop();
+		return false;
+	}
+
+	m_pThread = new std::thread(&CGlyphDeviceWatcher::WatcherThread, this, hReady);
+	WaitForSingleObject(hReady, INFINITE);
+	CloseHandle(hReady);
+
+	if (!m_hWindow) {
+		Stop();
+		return false;
+	}
+	return true;
+}
+
+void CGlyphDeviceWatcher::Stop()
+{
+	if (m_pThread) {
+		if (m_hWindow)
+			PostMessageA(m_hWindow, WM_CLOSE, 0, 0);
+		m_pThread->join();
+		delete m_pThread;
+		m_pThread = NULL;
+		m_hWindow = NULL;
+	}
+	if (m_hWakeEvent) {
+		CloseHandle(m_hWakeEvent);
+		m_hWakeEvent = NULL;
+	}
+}
+
+void CGlyphDeviceWatcher::Notify(std::atomic<uint32_t> &unCount)
+{
+	unCount.fetch_add(1, std::memory_order_relaxed);
+	SetEvent(m_hWakeEvent);
+}
+
+// Display changes are only broadcast to top level windows, so this is a
+// hidden top level window rather than a message-only one
+void CGlyphDeviceWatcher::WatcherThread(HANDLE hReady)
+{
+	HINSTANCE hInstance = GetModuleHandle(NULL);
+
+	WNDCLASSEXA windowClass = { 0 };
+	windowClass.cbSize = sizeof(WNDCLASSEXA);
+	windowClass.lpfnWndProc = staticWindowProc;
+	windowClass.hInstance = hInstance;
+	windowClass.lpszClassName = k_rchWatcherWindowClass;
+	if (!RegisterClassExA(&windowClass) && GetLastError() != ERROR_CLASS_ALREADY_EXISTS) {
+		DriverLog("Unable to register device watcher window: %i\n", GetLastError());
+		SetEvent(hReady);
+		return;
+	}
+
+	HWND hWindow = CreateWindowExA(0, k_rchWatcherWindowClass, k_rchWatcherWindowClass, 0, 0, 0, 0, 0, NULL, NULL, hInstance, NULL);
+	if (!hWindow) {
+		DriverLog("Unable to create device watcher window: %i\n", GetLastError());
+		UnregisterClassA(k_rchWatcherWindowClass, hInstance);
+		SetEvent(hReady);
+		return;
+	}
+	SetWindowLongPtrA(hWindow, GWLP_USERDATA, (LONG_PTR)this);
+
+	// DirectInput joysticks are HID devices too, so one filter covers both inputs
+	DEV_BROADCAST_DEVICEINTERFACE_A filter = { 0 };
+	filter.dbcc_size = sizeof(DEV_BROADCAST_DEVICEINTERFACE_A);
+	filter.dbcc_devicetype = DBT_DEVTYP_DEVICEINTERFACE;
+	HidD_GetHidGuid(&filter.dbcc_classguid);
+	HDEVNOTIFY hNotify = RegisterDeviceNotificationA(hWindow, &filter, DEVICE_NOTIFY_WINDOW_HANDLE);
+	if (!hNotify) {
+		DriverLog("Unable to register for device notifications: %i\n", GetLastError());
+	}
+
+	m_hWindow = hWindow;
+	SetEvent(hReady);
+
+	MSG msg;
+	while (GetMessageA(&msg, NULL, 0, 0) > 0) {
+		TranslateMessage(&msg);
+		DispatchMessageA(&msg);
+	}
+
+	if (hNotify)
+		UnregisterDeviceNotification(hNotify);
+	UnregisterClassA(k_rchWatcherWindowClass, hInstance);
+}
+
+LRESULT CALLBACK CGlyphDeviceWatcher::staticWindowProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
+{
+	CGlyphDeviceWatcher *pWatcher = (CGlyphDeviceWatcher *)GetWindowLongPtrA(hWnd, GWLP_USERDATA);
+
+	switch (uMsg) {
+	case WM_DEVICECHANGE:
+		if (pWatcher && (wParam == DBT_DEVICEARRIVAL || wParam == DBT_DEVICEREMOVECOMPLETE)) {
+			const DEV_BROADCAST_HDR *pHeader = (const DEV_BROADCAST_HDR *)lParam;
+			if (pHeader && pHeader->dbch_devicetype == DBT_DEVTYP_DEVICEINTERFACE) {
+				DRIVERLOG_DEBUG("HID device %s\n", wParam == DBT_DEVICEARRIVAL ? "arrived" : "removed");
+				pWatcher->Notify(pWatcher->m_unDeviceChanges);
+			}
+		}
+		return TRUE;
+
+	case WM_DISPLAYCHANGE:
+		if (pWatcher) {
+			DRIVERLOG_DEBUG("Display mode changed to %ux%u\n", LOWORD(lParam), HIWORD(lParam));
+			pWatcher->Notify(pWatcher->m_unDisplayChanges);
+		}
+		return 0;
+
+	case WM_CLOSE:
+		DestroyWindow(hWnd);
+		return 0;
+
+	case WM_DESTROY:
+		PostQuitMessage(0);
+		return 0;
+	}
+
+	return DefWindowProcA(hWnd, uMsg, wParam, lParam);
+}
@@ -0,0 +1,73 @@
+#ifndef GLYPH_INPUT_H
+#define GLYPH_INPUT_H
+
+#pragma once
+
+#include "glyph_sample.h"
+#include "glyph_wait.h"
+
+// USB IDs of the Glyph head tracker
+static const uint16_t k_unGlyphVendorId = 0x2C43;
+static const uint16_t k_unGlyphProductId = 0x0009;
+
+// history kept by the head tracking thread; tracker inputs append to it
+typedef CGlyphSampleRing<64> CGlyphSampleHistory;
+
+// --------------------------------------------------------------------------
+// Purpose: A way of reading raw reports from the Glyph head tracker. Open()
+//          first runs while the driver initializes; everything else runs
+//          on the head tracking thread, which also reopens the tracker with
+//          Stop(), Close(), Open() and Start() after it is unplugged.
+//          With several Glyphs attached, Open() takes the first one no
+//          other tracker of the same kind has open, and Close() gives it up.
+// --------------------------------------------------------------------------
+class IGlyphTrackerInput
+{
+public:
+	virtual ~IGlyphTrackerInput() {}
+
+	// short name for the log, e.g. "dinput"
+	virtual const char *GetName() const = 0;
+
+	// locate the tracker; false if it is not attached
+	virtual bool Open() = 0;
+	virtual bool IsOpen() const = 0;
+
+	// release the device so a later Open() can find it again
+	virtual void Close() = 0;
+
+	// false once reads show the tracker has gone, until it is reopened
+	virtual bool IsConnected() const = 0;
+
+	// buttons the open tracker reports in GlyphSample_t::unButtons, at most
+	// k_unGlyphMaxButtons
+	virtual uint32_t GetButtonCount() const = 0;
+
+	// set up reading before the first ReadSamples() and tear it down after the last
+	virtual void Start() = 0;
+	virtual void Stop() = 0;
+
+	// Handle signalled when a report may be waiting, or GLYPH_NO_WAIT_HANDLE
+	// if the tracker can only be polled. Valid between Start() and Stop().
+	virtual GlyphWaitHandle_t GetWaitHandle() const = 0;
+
+	// Append every report received since the last call, stamped with
+	// GlyphTicksNow() time. Returns the number of samples added.
+	virtual uint32_t ReadSamples(CGlyphSampleHistory *pSamples) = 0;
+};
+
+#if defined( _WINDOWS )
+// unIndex is the Glyph's rank among those the driver adds, the key of the
+// tracker instance it remembers between runs
+extern IGlyphTrackerInput *CreateDirectInputTracker(uint32_t unIndex);
+extern IGlyphTrackerInput *CreateHidTracker();
+#else
+// the tracker's evdev node under /dev/input, read through epoll
+extern IGlyphTrackerInput *CreateEvdevTracker();
+#endif
+
+// plays back a recording made with the recordFile setting
+extern IGlyphTrackerInput *CreateReplayTracker(const char *pchPath, bool bRealTime);
+
+
+#endif // GLYPH_INPUT_H
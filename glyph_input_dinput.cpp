@@ -0,0 +1,532 @@
+#include "glyph_input.h"
+#include "glyph_settings.h"
+#include "glyph_time.h"
+#include "driverlog.h"
+
+#define DIRECTINPUT_VERSION 0x800
+#include <windows.h>
+#include <dinput.h>
+#include <SetupAPI.h>
+#include <hidsdi.h>
+
+#include <mutex>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+// DirectInput's product GUID for a HID device packs its PID and VID into the
+// first field: {00092C43-0000-0000-0000-504944564944}
+static const GUID k_guidGlyphProduct = { ((DWORD)k_unGlyphProductId << 16) | k_unGlyphVendorId, 0x0000, 0x0000, { 0x00, 0x00, 'P', 'I', 'D', 'V', 'I', 'D' } };
+
+// what the Glyph's HID interface paths contain, lower case
+static const wchar_t k_rgwchGlyphHardwareId[] = L"vid_2c43&pid_0009";
+
+// reports DirectInput queues for us between wakeups in buffered mode
+static const DWORD k_unDeviceBufferSize = 64;
+
+// instances of the Glyph held open by some tracker, so each tracker gets its own
+static std::mutex s_claimMutex;
+static std::vector<GUID> s_vecClaimedInstances;
+
+static bool ClaimInstance(const GUID &guidInstance)
+{
+	std::lock_guard<std::mutex> lock(s_claimMutex);
+	for (size_t i = 0; i < s_vecClaimedInstances.size(); i++) {
+		if (IsEqualGUID(s_vecClaimedInstances[i], guidInstance))
+			return false;
+	}
+	s_vecClaimedInstances.push_back(guidInstance);
+	return true;
+}
+
+static void ReleaseInstance(const GUID &guidInstance)
+{
+	std::lock_guard<std::mutex> lock(s_claimMutex);
+	for (size_t i = 0; i < s_vecClaimedInstances.size(); i++) {
+		if (IsEqualGUID(s_vecClaimedInstances[i], guidInstance)) {
+			s_vecClaimedInstances.erase(s_vecClaimedInstances.begin() + i);
+			return;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Reads the tracker through the DirectInput joystick interface
+//-----------------------------------------------------------------------------
+class CGlyphDirectInputTracker : public IGlyphTrackerInput
+{
+public:
+	CGlyphDirectInputTracker(uint32_t unIndex)
+	{
+		m_unIndex = unIndex;
+		lpdi = NULL;
+		lpdiJoystick = NULL;
+		memset(&m_guidInstance, 0, sizeof(m_guidInstance));
+		m_unButtonCount = 0;
+		m_hSampleEvent = NULL;
+		m_bBuffered = false;
+		m_bufferedState = GlyphSample_t();
+		m_unNextSequence = 0;
+		m_unBufferOverflows = 0;
+		m_bUnplugged = false;
+
+		m_bEventDrivenInput = GlyphSettingBool(k_pch_Glyph_EventDrivenInput_Bool, true);
+		m_bBufferedInput = GlyphSettingBool(k_pch_Glyph_BufferedInput_Bool, true);
+
+		// GetTickCount advances by the clock interrupt period, in 100 ns units here
+		DWORD dwAdjustment, dwIncrement;
+		BOOL bAdjustmentDisabled;
+		m_dwTickPeriodMs = GetSystemTimeAdjustment(&dwAdjustment, &dwIncrement, &bAdjustmentDisabled) && dwIncrement ? (dwIncrement + 9999) / 10000 : 16;
+	}
+
+	virtual ~CGlyphDirectInputTracker()
+	{
+		Close();
+		if (lpdi) {
+			lpdi->Release();
+			lpdi = NULL;
+		}
+	}
+
+	virtual const char *GetName() const { return "dinput"; }
+
+	virtual bool Open()
+	{
+		if (lpdi == NULL && FAILED(DirectInput8Create(GetModuleHandle(NULL), DIRECTINPUT_VERSION, IID_IDirectInput8, (LPVOID *)&lpdi, NULL))) {
+			lpdi = NULL;
+			return false;
+		}
+
+		// The instance found last time is checked first, then the HID
+		// interfaces with the Glyph's VID and PID. Enumerating every game
+		// controller, which has DirectInput probe each one, is the last resort,
+		// only taken when the VID/PID lookup could not give a complete answer.
+		// A lookup that ran and found no unclaimed Glyph is final, so probing
+		// for a second Glyph or a reconnect stays cheap.
+		m_bUnplugged = false;
+		int64_t nStart = GlyphTicksNow();
+		const char *pchFoundBy;
+		EHardwareIdLookup eLookup = HardwareIdLookup_Unavailable;
+		if (OpenRememberedInstance()) {
+			pchFoundBy = "remembered instance";
+		}
+		else if ((eLookup = OpenByHardwareId()) == HardwareIdLookup_Found) {
+			pchFoundBy = "VID/PID";
+		}
+		else if (eLookup == HardwareIdLookup_NotFound) {
+			return false;
+		}
+		else {
+			lpdi->EnumDevices(DI8DEVCLASS_GAMECTRL, staticGamepadSelect, this, DIEDFL_ATTACHEDONLY);
+
+			float flEnumerationMs = (float)(1000.0 * GlyphTicksToSeconds(GlyphTicksNow() - nStart));
+			vr::VRSettings()->SetFloat(k_pch_Glyph_Section, k_pch_Glyph_TrackerEnumerationMs_Float, flEnumerationMs);
+			if (lpdiJoystick == NULL) {
+				DriverLog("No Glyph tracker found by full enumeration in %.2f ms\n", flEnumerationMs);
+				return false;
+			}
+
+			RememberInstance();
+			DriverLog("Glyph tracker found by full enumeration in %.2f ms\n", flEnumerationMs);
+			return true;
+		}
+
+		double flMs = 1000.0 * GlyphTicksToSeconds(GlyphTicksNow() - nStart);
+		float flEnumerationMs = GlyphSettingFloat(k_pch_Glyph_TrackerEnumerationMs_Float, 0.0f);
+		if (flEnumerationMs > 0) {
+			DriverLog("Glyph tracker found by %s in %.2f ms, %.2f ms less than the last full enumeration\n", pchFoundBy, flMs, flEnumerationMs - flMs);
+		}
+		else {
+			DriverLog("Glyph tracker found by %s in %.2f ms\n", pchFoundBy, flMs);
+		}
+		return true;
+	}
+
+	virtual bool IsOpen() const { return lpdiJoystick != NULL; }
+
+	virtual void Close()
+	{
+		if (lpdiJoystick) {
+			lpdiJoystick->Release();
+			lpdiJoystick = NULL;
+			ReleaseInstance(m_guidInstance);
+		}
+	}
+
+	virtual bool IsConnected() const { return lpdiJoystick != NULL && !m_bUnplugged; }
+
+	virtual uint32_t GetButtonCount() const { return lpdiJoystick != NULL ? m_unButtonCount : 0; }
+
+	virtual void Start()
+	{
+		if (lpdiJoystick == NULL)
+			return;
+
+		bool bEventDriven = m_bEventDrivenInput && EnableSampleEvent();
+		m_bBuffered = m_bBufferedInput && EnableDeviceBuffer();
+		DriverLog("DirectInput tracker in %s mode, %s reads\n", bEventDriven ? "event" : "polling", m_bBuffered ? "buffered" : "immediate");
+	}
+
+	virtual void Stop()
+	{
+		if (lpdiJoystick == NULL)
+			return;
+
+		lpdiJoystick->Unacquire();
+		DisableSampleEvent();
+		if (m_unBufferOverflows) {
+			DriverLog("Tracker buffer overflowed %u times\n", m_unBufferOverflows);
+		}
+	}
+
+	virtual GlyphWaitHandle_t GetWaitHandle() const { return m_hSampleEvent; }
+
+	virtual uint32_t ReadSamples(CGlyphSampleHistory *pSamples)
+	{
+		if (lpdiJoystick == NULL || m_bUnplugged)
+			return 0;
+
+		HRESULT hr = lpdiJoystick->Poll();
+		int64_t nReadTicks = GlyphTicksNow();
+
+		if (FAILED(hr)) {
+			hr = lpdiJoystick->Acquire();
+			if (SUCCEEDED(hr)) {
+				return m_bBuffered ? SeedBufferedState(pSamples, nReadTicks) : 0;
+			}
+			// anything but losing focus to an exclusive user means the tracker is
+			// gone; stop acquiring and let the head tracking thread reopen it
+			if (hr != DIERR_OTHERAPPHASPRIO) {
+				DriverLog("Glyph gamepad lost (0x%08lx)\n", hr);
+				m_bUnplugged = true;
+			}
+			return 0;
+		}
+
+		return m_bBuffered ? ReadBufferedSamples(pSamples, nReadTicks) : ReadImmediateSample(pSamples, nReadTicks);
+	}
+
+private:
+	static BOOL CALLBACK staticGamepadSelect(LPCDIDEVICEINSTANCE lpddi, LPVOID pvRef)
+	{
+		CGlyphDirectInputTracker * thisClass = (CGlyphDirectInputTracker *)pvRef;
+
+		return thisClass->GamepadSelect(lpddi);
+	}
+
+	BOOL CALLBACK GamepadSelect(LPCDIDEVICEINSTANCE lpddi)
+	{
+		if (!IsEqualGUID(lpddi->guidProduct, k_guidGlyphProduct)) {
+#if DRIVERLOG_ENABLE_DEBUG
+			char ProductName[260];
+			wcstombs_s(NULL, ProductName, lpddi->tszProductName, 260);
+			DRIVERLOG_DEBUG("Non Glyph Gamepad found: %s\n", ProductName);
+#endif
+			return DIENUM_CONTINUE;
+		}
+
+		return AttachInstance(lpddi->guidInstance) ? DIENUM_STOP : DIENUM_CONTINUE;
+	}
+
+	// Claim and open an attached Glyph by instance GUID
+	bool AttachInstance(const GUID &guidInstance)
+	{
+		if (!ClaimInstance(guidInstance))
+			return false;
+		if (FAILED(lpdi->CreateDevice(guidInstance, &lpdiJoystick, NULL))) {
+			lpdiJoystick = NULL;
+			ReleaseInstance(guidInstance);
+			return false;
+		}
+
+		// a remembered or looked up instance may belong to something else by now
+		DIDEVICEINSTANCE instance = { 0 };
+		instance.dwSize = sizeof(DIDEVICEINSTANCE);
+		if (FAILED(lpdiJoystick->GetDeviceInfo(&instance)) || !IsEqualGUID(instance.guidProduct, k_guidGlyphProduct)) {
+			lpdiJoystick->Release();
+			lpdiJoystick = NULL;
+			ReleaseInstance(guidInstance);
+			return false;
+		}
+
+		m_guidInstance = guidInstance;
+		lpdiJoystick->SetDataFormat(&c_dfDIJoystick2);
+
+		DIDEVCAPS caps = { 0 };
+		caps.dwSize = sizeof(DIDEVCAPS);
+		m_unButtonCount = SUCCEEDED(lpdiJoystick->GetCapabilities(&caps)) ? std::min<uint32_t>(caps.dwButtons, k_unGlyphMaxButtons) : 0;
+
+		char ProductName[260];
+		wcstombs_s(NULL, ProductName, instance.tszProductName, 260);
+		DriverLog("Glyph gamepad found: %s\n", ProductName);
+		return true;
+	}
+
+	// the instance this Glyph was opened as on an earlier run, if still attached
+	bool OpenRememberedInstance()
+	{
+		char rchKey[64];
+		GlyphIndexedSettingKey(k_pch_Glyph_TrackerInstance_String, m_unIndex, rchKey, sizeof(rchKey));
+		char rchInstance[64];
+		GlyphSettingString(rchKey, rchInstance, sizeof(rchInstance), "");
+		if (!rchInstance[0])
+			return false;
+
+		wchar_t wchInstance[64];
+		GUID guidInstance;
+		if (mbstowcs_s(NULL, wchInstance, rchInstance, _TRUNCATE) != 0 || FAILED(CLSIDFromString(wchInstance, &guidInstance)))
+			return false;
+		if (lpdi->GetDeviceStatus(guidInstance) != DI_OK)
+			return false;
+
+		return AttachInstance(guidInstance);
+	}
+
+	enum EHardwareIdLookup
+	{
+		HardwareIdLookup_Found,
+		HardwareIdLookup_NotFound,		// every Glyph interface present is claimed, or none is
+		HardwareIdLookup_Unavailable,	// SetupAPI failed, or DirectInput could not map a Glyph interface
+	};
+
+	// Look the HID interfaces up by VID and PID and have DirectInput map
+	// each match to its instance, so no other device is opened or probed
+	EHardwareIdLookup OpenByHardwareId()
+	{
+		GUID hidGuid;
+		HidD_GetHidGuid(&hidGuid);
+
+		HDEVINFO hDevInfo = SetupDiGetClassDevsW(&hidGuid, NULL, NULL, DIGCF_PRESENT | DIGCF_DEVICEINTERFACE);
+		if (hDevInfo == INVALID_HANDLE_VALUE)
+			return HardwareIdLookup_Unavailable;
+
+		bool bUnmapped = false;
+
+		SP_DEVICE_INTERFACE_DATA interfaceData;
+		interfaceData.cbSize = sizeof(SP_DEVICE_INTERFACE_DATA);
+		for (DWORD dwIndex = 0; lpdiJoystick == NULL && SetupDiEnumDeviceInterfaces(hDevInfo, NULL, &hidGuid, dwIndex, &interfaceData); dwIndex++) {
+			DWORD dwRequired = 0;
+			SetupDiGetDeviceInterfaceDetailW(hDevInfo, &interfaceData, NULL, 0, &dwRequired, NULL);
+			if (dwRequired == 0)
+				continue;
+
+			std::vector<char> detailBuffer(dwRequired);
+			SP_DEVICE_INTERFACE_DETAIL_DATA_W *pDetail = (SP_DEVICE_INTERFACE_DETAIL_DATA_W *)&detailBuffer[0];
+			pDetail->cbSize = sizeof(SP_DEVICE_INTERFACE_DETAIL_DATA_W);
+			if (!SetupDiGetDeviceInterfaceDetailW(hDevInfo, &interfaceData, pDetail, dwRequired, NULL, NULL))
+				continue;
+
+			std::wstring sPath(pDetail->DevicePath);
+			std::transform(sPath.begin(), sPath.end(), sPath.begin(), towlower);
+			if (sPath.find(k_rgwchGlyphHardwareId) == std::wstring::npos)
+				continue;
+
+			GUID guidInstance;
+			if (SUCCEEDED(lpdi->FindDevice(hidGuid, pDetail->DevicePath, &guidInstance))) {
+				AttachInstance(guidInstance);
+			}
+			else {
+				bUnmapped = true;
+			}
+		}
+
+		SetupDiDestroyDeviceInfoList(hDevInfo);
+		if (lpdiJoystick == NULL)
+			return bUnmapped ? HardwareIdLookup_Unavailable : HardwareIdLookup_NotFound;
+
+		RememberInstance();
+		return HardwareIdLookup_Found;
+	}
+
+	void RememberInstance()
+	{
+		wchar_t wchInstance[64];
+		char rchInstance[64];
+		StringFromGUID2(m_guidInstance, wchInstance, 64);
+		wcstombs_s(NULL, rchInstance, wchInstance, 64);
+
+		char rchKey[64];
+		GlyphIndexedSettingKey(k_pch_Glyph_TrackerInstance_String, m_unIndex, rchKey, sizeof(rchKey));
+		vr::VRSettings()->SetString(k_pch_Glyph_Section, rchKey, rchInstance);
+	}
+
+	// Ask DirectInput to signal an event whenever the tracker reports new data.
+	// Must be called while the device is unacquired. Returns false if the device
+	// has to be polled, in which case the caller falls back to the sleep loop.
+	bool EnableSampleEvent()
+	{
+		DIDEVCAPS caps = { 0 };
+		caps.dwSize = sizeof(DIDEVCAPS);
+		if (SUCCEEDED(lpdiJoystick->GetCapabilities(&caps)) && (caps.dwFlags & DIDC_POLLEDDEVICE)) {
+			DriverLog("Glyph gamepad requires polling, event notification unavailable\n");
+			return false;
+		}
+
+		m_hSampleEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+		if (!m_hSampleEvent) {
+			DriverLog("Unable to create tracker event: %i\n", GetLastError());
+			return false;
+		}
+
+		HRESULT hr = lpdiJoystick->SetEventNotification(m_hSampleEvent);
+		if (FAILED(hr) || hr == DI_POLLEDDEVICE) {
+			DriverLog("SetEventNotification failed (0x%08lx), using polling\n", hr);
+			lpdiJoystick->SetEventNotification(NULL);
+			CloseHandle(m_hSampleEvent);
+			m_hSampleEvent = NULL;
+			return false;
+		}
+
+		return true;
+	}
+
+	void DisableSampleEvent()
+	{
+		if (m_hSampleEvent) {
+			lpdiJoystick->SetEventNotification(NULL);
+			CloseHandle(m_hSampleEvent);
+			m_hSampleEvent = NULL;
+		}
+	}
+
+	// Ask DirectInput to queue every report instead of only keeping the latest
+	// state. Must be called while the device is unacquired.
+	bool EnableDeviceBuffer()
+	{
+		DIPROPDWORD bufferSize = { 0 };
+		bufferSize.diph.dwSize = sizeof(DIPROPDWORD);
+		bufferSize.diph.dwHeaderSize = sizeof(DIPROPHEADER);
+		bufferSize.diph.dwObj = 0;
+		bufferSize.diph.dwHow = DIPH_DEVICE;
+		bufferSize.dwData = k_unDeviceBufferSize;
+
+		HRESULT hr = lpdiJoystick->SetProperty(DIPROP_BUFFERSIZE, &bufferSize.diph);
+		if (FAILED(hr)) {
+			DriverLog("Unable to set tracker buffer size (0x%08lx), using immediate reads\n", hr);
+			return false;
+		}
+		return true;
+	}
+
+	static void SampleFromJoyState(const DIJOYSTATE2 &state, GlyphSample_t *pSample)
+	{
+		pSample->rgnAxis[GlyphAxis_X] = state.lX;
+		pSample->rgnAxis[GlyphAxis_Y] = state.lY;
+		pSample->rgnAxis[GlyphAxis_Z] = state.lZ;
+		pSample->rgnAxis[GlyphAxis_RX] = state.lRx;
+		pSample->rgnAxis[GlyphAxis_RY] = state.lRy;
+		pSample->rgnAxis[GlyphAxis_RZ] = state.lRz;
+		pSample->rgnAxis[GlyphAxis_Slider0] = state.rglSlider[0];
+		pSample->rgnAxis[GlyphAxis_Slider1] = state.rglSlider[1];
+
+		pSample->unButtons = 0;
+		for (uint32_t i = 0; i < k_unGlyphMaxButtons; i++) {
+			if (state.rgbButtons[i] & 0x80)
+				pSample->unButtons |= 1u << i;
+		}
+	}
+
+	// Immediate mode: the current device state becomes one sample stamped with
+	// the time we read it. Returns the number of samples added.
+	uint32_t ReadImmediateSample(CGlyphSampleHistory *pSamples, int64_t nReadTicks)
+	{
+		DIJOYSTATE2 joyState = { 0 };
+		if (FAILED(lpdiJoystick->GetDeviceState(sizeof(DIJOYSTATE2), &joyState)))
+			return 0;
+
+		GlyphSample_t sample;
+		SampleFromJoyState(joyState, &sample);
+		sample.unSequence = m_unNextSequence++;
+		sample.nTimestamp = nReadTicks;
+		pSamples->Push(sample);
+		return 1;
+	}
+
+	// Buffered mode starts from a full state snapshot, since the buffer only
+	// carries changes made after it was acquired.
+	uint32_t SeedBufferedState(CGlyphSampleHistory *pSamples, int64_t nReadTicks)
+	{
+		DIJOYSTATE2 joyState = { 0 };
+		if (FAILED(lpdiJoystick->GetDeviceState(sizeof(DIJOYSTATE2), &joyState)))
+			return 0;
+
+		SampleFromJoyState(joyState, &m_bufferedState);
+		m_bufferedState.nTimestamp = nReadTicks;
+		pSamples->Push(m_bufferedState);
+		return 1;
+	}
+
+	// Buffered mode: drain every queued report. Objects that share a DirectInput
+	// sequence number changed in the same report and form one sample. The
+	// DirectInput timestamps only have GetTickCount resolution, so samples are
+	// stamped with the high resolution read time minus their tick count age.
+	// An age under one tick period says nothing, so it counts as none, and no
+	// sample is stamped before the one pushed ahead of it; the predictor
+	// needs its samples in time order. Returns the number of samples added.
+	uint32_t ReadBufferedSamples(CGlyphSampleHistory *pSamples, int64_t nReadTicks)
+	{
+		DIDEVICEOBJECTDATA rgData[k_unDeviceBufferSize];
+		const DWORD dwReadTime = GetTickCount();
+		const int64_t nTicksPerMs = GlyphTicksPerSecond() / 1000;
+		uint32_t unNewSamples = 0;
+		DWORD dwItems;
+		HRESULT hr;
+
+		do {
+			dwItems = k_unDeviceBufferSize;
+			hr = lpdiJoystick->GetDeviceData(sizeof(DIDEVICEOBJECTDATA), rgData, &dwItems, 0);
+			if (FAILED(hr))
+				return unNewSamples;
+			if (hr == DI_BUFFEROVERFLOW)
+				m_unBufferOverflows++;
+
+			for (DWORD i = 0; i < dwItems; i++) {
+				const DIDEVICEOBJECTDATA &data = rgData[i];
+				if (data.dwOfs <= DIJOFS_SLIDER(1)) {
+					m_bufferedState.rgnAxis[data.dwOfs / sizeof(LONG)] = (int32_t)data.dwData;
+				}
+				else if (data.dwOfs >= DIJOFS_BUTTON0 && data.dwOfs < DIJOFS_BUTTON(k_unGlyphMaxButtons)) {
+					uint32_t unBit = 1u << (data.dwOfs - DIJOFS_BUTTON0);
+					m_bufferedState.unButtons = (data.dwData & 0x80) ? m_bufferedState.unButtons | unBit : m_bufferedState.unButtons & ~unBit;
+				}
+
+				if (i + 1 == dwItems || rgData[i + 1].dwSequence != data.dwSequence) {
+					// a report stamped after dwReadTime was taken has no age yet
+					DWORD dwAgeMs = dwReadTime - data.dwTimeStamp;
+					if (dwAgeMs > 0x7fffffff || dwAgeMs < m_dwTickPeriodMs)
+						dwAgeMs = 0;
+
+					int64_t nTimestamp = nReadTicks - (int64_t)dwAgeMs * nTicksPerMs;
+					m_bufferedState.unSequence = data.dwSequence;
+					m_bufferedState.nTimestamp = std::max<int64_t>(nTimestamp, m_bufferedState.nTimestamp);
+					pSamples->Push(m_bufferedState);
+					unNewSamples++;
+				}
+			}
+		} while (dwItems == k_unDeviceBufferSize);
+
+		return unNewSamples;
+	}
+
+	uint32_t m_unIndex;
+	LPDIRECTINPUT8	lpdi;
+	LPDIRECTINPUTDEVICE8  lpdiJoystick;
+	GUID m_guidInstance;	// claimed while lpdiJoystick is open
+	uint32_t m_unButtonCount;
+	HANDLE m_hSampleEvent;
+
+	bool m_bEventDrivenInput;
+	bool m_bBufferedInput;
+	bool m_bBuffered;
+	bool m_bUnplugged;
+
+	GlyphSample_t m_bufferedState;	// also holds the last buffered sample time
+	uint32_t m_unNextSequence;
+	DWORD m_dwTickPeriodMs;
+	uint32_t m_unBufferOverflows;
+};
+
+IGlyphTrackerInput *CreateDirectInputTracker(uint32_t unIndex)
+{
+	return new CGlyphDirectInputTracker(unIndex);
+}
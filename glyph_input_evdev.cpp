@@ -0,0 +1,395 @@
+#include "glyph_input.h"
+#include "glyph_time.h"
+#include "driverlog.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/input.h>
+
+#include <vector>
+#include <string>
+#include <mutex>
+#include <algorithm>
+
+// events taken per read(); the rest wait for the next one
+static const size_t k_unEventsPerRead = 64;
+
+// evdev axes in EGlyphAxis order; the input layer maps the HID X..RZ usages
+// to ABS_X..ABS_RZ and the two sliders to the next free codes
+static const uint16_t k_rgAxisCodes[GlyphAxis_Count] =
+{
+	ABS_X,
+	ABS_Y,
+	ABS_Z,
+	ABS_RX,
+	ABS_RY,
+	ABS_RZ,
+	ABS_THROTTLE,
+	ABS_RUDDER,
+};
+
+// event nodes held open by some tracker, so each tracker gets its own Glyph
+static std::mutex s_claimMutex;
+static std::vector<std::string> s_vecClaimedPaths;
+
+static bool ClaimPath(const char *pchPath)
+{
+	std::lock_guard<std::mutex> lock(s_claimMutex);
+	if (std::find(s_vecClaimedPaths.begin(), s_vecClaimedPaths.end(), pchPath) != s_vecClaimedPaths.end())
+		return false;
+	s_vecClaimedPaths.push_back(pchPath);
+	return true;
+}
+
+static void ReleasePath(const std::string &sPath)
+{
+	std::lock_guard<std::mutex> lock(s_claimMutex);
+	std::vector<std::string>::iterator it = std::find(s_vecClaimedPaths.begin(), s_vecClaimedPaths.end(), sPath);
+	if (it != s_vecClaimedPaths.end())
+		s_vecClaimedPaths.erase(it);
+}
+
+static bool TestBit(const uint8_t *pBits, uint32_t unBit)
+{
+	return (pBits[unBit / 8] >> (unBit % 8)) & 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Reads the tracker's evdev node, the Linux counterpart of the HID
+//          input. The node's descriptor is the wait handle, so the tracking
+//          thread's epoll wakes exactly when reports arrive. Axis values are
+//          scaled to 0..65535 as DirectInput reports them, and each sample
+//          carries the kernel's CLOCK_MONOTONIC timestamp of its SYN_REPORT,
+//          the clock GlyphTicksNow() reads.
+//-----------------------------------------------------------------------------
+class CGlyphEvdevTracker : public IGlyphTrackerInput
+{
+public:
+	CGlyphEvdevTracker()
+	{
+		m_nFd = -1;
+		m_unButtonCount = 0;
+		m_bUnplugged = false;
+		m_bDropping = false;
+		m_bSeedPending = false;
+		m_unResyncs = 0;
+		m_state = GlyphSample_t();
+		m_unNextSequence = 0;
+		memset(m_rgAxes, 0, sizeof(m_rgAxes));
+		memset(m_rgnButtonBits, -1, sizeof(m_rgnButtonBits));
+	}
+
+	virtual ~CGlyphEvdevTracker()
+	{
+		Stop();
+		Close();
+	}
+
+	virtual const char *GetName() const { return "evdev"; }
+
+	virtual bool Open()
+	{
+		DIR *pDir = opendir("/dev/input");
+		if (!pDir) {
+			DriverLog("Unable to list /dev/input: %i\n", errno);
+			return false;
+		}
+
+		struct dirent *pEntry;
+		while (m_nFd < 0 && (pEntry = readdir(pDir)) != NULL) {
+			if (strncmp(pEntry->d_name, "event", 5))
+				continue;
+
+			char rchPath[PATH_MAX];
+			snprintf(rchPath, sizeof(rchPath), "/dev/input/%s", pEntry->d_name);
+			TryOpenPath(rchPath);
+		}
+
+		closedir(pDir);
+		m_bUnplugged = false;
+		return m_nFd >= 0;
+	}
+
+	virtual bool IsOpen() const { return m_nFd >= 0; }
+
+	virtual void Close()
+	{
+		if (m_nFd >= 0) {
+			close(m_nFd);
+			m_nFd = -1;
+			ReleasePath(m_sPath);
+			m_sPath.clear();
+		}
+		m_bUnplugged = false;
+	}
+
+	virtual bool IsConnected() const { return m_nFd >= 0 && !m_bUnplugged; }
+
+	virtual uint32_t GetButtonCount() const { return m_nFd >= 0 ? m_unButtonCount : 0; }
+
+	virtual void Start()
+	{
+		if (m_nFd < 0)
+			return;
+
+		// evdev only reports changes, so a head held still would send nothing;
+		// start from a snapshot, taken after dropping whatever was queued
+		// before it so that later events are all newer
+		DiscardQueuedEvents();
+		m_bDropping = false;
+		ReadCurrentState();
+		m_state.unSequence = m_unNextSequence++;
+		m_state.nTimestamp = GlyphTicksNow();
+		m_bSeedPending = true;
+	}
+
+	virtual void Stop()
+	{
+		if (m_unResyncs) {
+			DriverLog("Tracker event queue overflowed %u times\n", m_unResyncs);
+			m_unResyncs = 0;
+		}
+	}
+
+	virtual GlyphWaitHandle_t GetWaitHandle() const { return m_nFd; }
+
+	virtual uint32_t ReadSamples(CGlyphSampleHistory *pSamples)
+	{
+		if (m_nFd < 0 || m_bUnplugged)
+			return 0;
+
+		uint32_t unNewSamples = 0;
+		if (m_bSeedPending) {
+			pSamples->Push(m_state);
+			m_bSeedPending = false;
+			unNewSamples++;
+		}
+
+		struct input_event rgEvents[k_unEventsPerRead];
+		for (;;) {
+			ssize_t nBytes = read(m_nFd, rgEvents, sizeof(rgEvents));
+			if (nBytes < 0) {
+				if (errno == EINTR)
+					continue;
+				// anything but an empty queue means the tracker is gone; the
+				// head tracking thread reopens it
+				if (errno != EAGAIN) {
+					DriverLog("Glyph evdev tracker lost: %i\n", errno);
+					m_bUnplugged = true;
+				}
+				break;
+			}
+
+			size_t unEvents = (size_t)nBytes / sizeof(struct input_event);
+			for (size_t i = 0; i < unEvents; i++) {
+				if (HandleEvent(rgEvents[i])) {
+					pSamples->Push(m_state);
+					unNewSamples++;
+				}
+			}
+			if (unEvents < k_unEventsPerRead)
+				break;
+		}
+
+		return unNewSamples;
+	}
+
+private:
+	struct AxisInfo_t
+	{
+		bool bPresent;
+		int32_t nMinimum;
+		int32_t nMaximum;
+	};
+
+	void TryOpenPath(const char *pchPath)
+	{
+		int nFd = open(pchPath, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+		if (nFd < 0)
+			return;
+
+		struct input_id id;
+		if (ioctl(nFd, EVIOCGID, &id) < 0 || id.vendor != k_unGlyphVendorId || id.product != k_unGlyphProductId) {
+			close(nFd);
+			return;
+		}
+
+		// the tracker can expose several nodes; use the one carrying the orientation axes
+		if (!ReadAxisInfo(nFd) || !ClaimPath(pchPath)) {
+			close(nFd);
+			return;
+		}
+
+		int nClock = CLOCK_MONOTONIC;
+		if (ioctl(nFd, EVIOCSCLOCKID, &nClock) < 0) {
+			DriverLog("Unable to use monotonic event timestamps, using read times instead\n");
+			m_bMonotonicTimestamps = false;
+		}
+		else {
+			m_bMonotonicTimestamps = true;
+		}
+
+		ReadButtonInfo(nFd);
+
+		char rchName[128] = "";
+		ioctl(nFd, EVIOCGNAME(sizeof(rchName)), rchName);
+		m_nFd = nFd;
+		m_sPath = pchPath;
+		DriverLog("Glyph evdev tracker found: %s (%s, %u buttons)\n", pchPath, rchName, m_unButtonCount);
+	}
+
+	bool ReadAxisInfo(int nFd)
+	{
+		uint8_t rgAbsBits[ABS_MAX / 8 + 1];
+		memset(rgAbsBits, 0, sizeof(rgAbsBits));
+		if (ioctl(nFd, EVIOCGBIT(EV_ABS, sizeof(rgAbsBits)), rgAbsBits) < 0)
+			return false;
+
+		memset(m_rgAxes, 0, sizeof(m_rgAxes));
+		for (int nAxis = 0; nAxis < GlyphAxis_Count; nAxis++) {
+			struct input_absinfo absInfo;
+			if (!TestBit(rgAbsBits, k_rgAxisCodes[nAxis]) || ioctl(nFd, EVIOCGABS(k_rgAxisCodes[nAxis]), &absInfo) < 0)
+				continue;
+
+			m_rgAxes[nAxis].bPresent = true;
+			m_rgAxes[nAxis].nMinimum = absInfo.minimum;
+			m_rgAxes[nAxis].nMaximum = absInfo.maximum;
+		}
+
+		return m_rgAxes[GlyphAxis_Y].bPresent && m_rgAxes[GlyphAxis_Z].bPresent && m_rgAxes[GlyphAxis_RX].bPresent;
+	}
+
+	// Buttons are numbered in the order of their key codes, which is the
+	// order of the HID button usages the input layer mapped them from
+	void ReadButtonInfo(int nFd)
+	{
+		uint8_t rgKeyBits[KEY_MAX / 8 + 1];
+		memset(rgKeyBits, 0, sizeof(rgKeyBits));
+		memset(m_rgnButtonBits, -1, sizeof(m_rgnButtonBits));
+		m_unButtonCount = 0;
+		if (ioctl(nFd, EVIOCGBIT(EV_KEY, sizeof(rgKeyBits)), rgKeyBits) < 0)
+			return;
+
+		for (uint32_t unCode = BTN_MISC; unCode <= KEY_MAX && m_unButtonCount < k_unGlyphMaxButtons; unCode++) {
+			if (TestBit(rgKeyBits, unCode)) {
+				m_rgnButtonBits[unCode] = (int8_t)m_unButtonCount++;
+			}
+		}
+	}
+
+	int32_t ScaleAxis(const AxisInfo_t &axis, int32_t nValue) const
+	{
+		int64_t nRange = (int64_t)axis.nMaximum - axis.nMinimum;
+		return nRange > 0 ? (int32_t)(((int64_t)nValue - axis.nMinimum) * 65535 / nRange) : nValue;
+	}
+
+	// Drop the events queued before a snapshot of the device state
+	void DiscardQueuedEvents()
+	{
+		struct input_event rgEvents[k_unEventsPerRead];
+		ssize_t nBytes;
+		do {
+			nBytes = read(m_nFd, rgEvents, sizeof(rgEvents));
+		} while (nBytes == (ssize_t)sizeof(rgEvents) || (nBytes < 0 && errno == EINTR));
+	}
+
+	// Reload every axis and button from the device, after an overflow lost
+	// events or before the first read
+	void ReadCurrentState()
+	{
+		for (int nAxis = 0; nAxis < GlyphAxis_Count; nAxis++) {
+			struct input_absinfo absInfo;
+			if (m_rgAxes[nAxis].bPresent && ioctl(m_nFd, EVIOCGABS(k_rgAxisCodes[nAxis]), &absInfo) >= 0)
+				m_state.rgnAxis[nAxis] = ScaleAxis(m_rgAxes[nAxis], absInfo.value);
+		}
+
+		uint8_t rgKeyBits[KEY_MAX / 8 + 1];
+		memset(rgKeyBits, 0, sizeof(rgKeyBits));
+		if (m_unButtonCount && ioctl(m_nFd, EVIOCGKEY(sizeof(rgKeyBits)), rgKeyBits) >= 0) {
+			m_state.unButtons = 0;
+			for (uint32_t unCode = BTN_MISC; unCode <= KEY_MAX; unCode++) {
+				if (m_rgnButtonBits[unCode] >= 0 && TestBit(rgKeyBits, unCode))
+					m_state.unButtons |= 1u << m_rgnButtonBits[unCode];
+			}
+		}
+	}
+
+	// Fold one event into m_state; true once a SYN_REPORT completes a sample
+	bool HandleEvent(const struct input_event &event)
+	{
+		if (event.type == EV_SYN) {
+			if (event.code == SYN_DROPPED) {
+				// the kernel queue overflowed; what follows up to the next
+				// SYN_REPORT is incomplete, so resynchronize there
+				m_bDropping = true;
+				m_unResyncs++;
+				return false;
+			}
+			if (event.code != SYN_REPORT)
+				return false;
+
+			if (m_bDropping) {
+				m_bDropping = false;
+				ReadCurrentState();
+			}
+			m_state.unSequence = m_unNextSequence++;
+			m_state.nTimestamp = EventTicks(event);
+			return true;
+		}
+
+		if (m_bDropping)
+			return false;
+
+		if (event.type == EV_ABS) {
+			for (int nAxis = 0; nAxis < GlyphAxis_Count; nAxis++) {
+				if (m_rgAxes[nAxis].bPresent && k_rgAxisCodes[nAxis] == event.code) {
+					m_state.rgnAxis[nAxis] = ScaleAxis(m_rgAxes[nAxis], event.value);
+					break;
+				}
+			}
+		}
+		else if (event.type == EV_KEY && event.code <= KEY_MAX && m_rgnButtonBits[event.code] >= 0) {
+			uint32_t unBit = 1u << m_rgnButtonBits[event.code];
+			m_state.unButtons = event.value ? m_state.unButtons | unBit : m_state.unButtons & ~unBit;
+		}
+		return false;
+	}
+
+	// GlyphTicksNow() time of an event, never later than now
+	int64_t EventTicks(const struct input_event &event) const
+	{
+		int64_t nNow = GlyphTicksNow();
+		if (!m_bMonotonicTimestamps)
+			return nNow;
+
+		int64_t nTicks = (int64_t)event.input_event_sec * 1000000000 + (int64_t)event.input_event_usec * 1000;
+		return nTicks < nNow ? nTicks : nNow;
+	}
+
+	int m_nFd;
+	std::string m_sPath;	// claimed while m_nFd is open
+	AxisInfo_t m_rgAxes[GlyphAxis_Count];
+	int8_t m_rgnButtonBits[KEY_MAX + 1];	// bit in unButtons of each key code, or -1
+	uint32_t m_unButtonCount;
+	bool m_bMonotonicTimestamps;
+	bool m_bUnplugged;
+
+	bool m_bDropping;		// between SYN_DROPPED and the next SYN_REPORT
+	bool m_bSeedPending;	// m_state is the snapshot Start() took, not yet read
+	uint32_t m_unResyncs;
+
+	GlyphSample_t m_state;
+	uint32_t m_unNextSequence;
+};
+
+IGlyphTrackerInput *CreateEvdevTracker()
+{
+	return new CGlyphEvdevTracker();
+}
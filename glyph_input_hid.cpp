@@ -0,0 +1,390 @@
+#include "glyph_input.h"
+#include "glyph_time.h"
+#include "driverlog.h"
+
+#include <windows.h>
+#include <SetupAPI.h>
+#include <hidsdi.h>
+
+#include <vector>
+#include <string>
+#include <mutex>
+#include <algorithm>
+
+// HID usages of the axes, in EGlyphAxis order; both sliders share one usage
+static const USAGE k_rgAxisUsages[GlyphAxis_Count] =
+{
+	HID_USAGE_GENERIC_X,
+	HID_USAGE_GENERIC_Y,
+	HID_USAGE_GENERIC_Z,
+	HID_USAGE_GENERIC_RX,
+	HID_USAGE_GENERIC_RY,
+	HID_USAGE_GENERIC_RZ,
+	HID_USAGE_GENERIC_SLIDER,
+	HID_USAGE_GENERIC_SLIDER,
+};
+
+// button usages read from one report at most
+static const ULONG k_unMaxUsages = 128;
+
+// device paths held open by some tracker, so each tracker gets its own Glyph
+static std::mutex s_claimMutex;
+static std::vector<std::string> s_vecClaimedPaths;
+
+static bool ClaimPath(const char *pchPath)
+{
+	std::lock_guard<std::mutex> lock(s_claimMutex);
+	if (std::find(s_vecClaimedPaths.begin(), s_vecClaimedPaths.end(), pchPath) != s_vecClaimedPaths.end())
+		return false;
+	s_vecClaimedPaths.push_back(pchPath);
+	return true;
+}
+
+static void ReleasePath(const std::string &sPath)
+{
+	std::lock_guard<std::mutex> lock(s_claimMutex);
+	std::vector<std::string>::iterator it = std::find(s_vecClaimedPaths.begin(), s_vecClaimedPaths.end(), sPath);
+	if (it != s_vecClaimedPaths.end())
+		s_vecClaimedPaths.erase(it);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Reads the tracker's HID input reports directly with overlapped I/O,
+//          without the DirectInput translation layer. Axis values are scaled
+//          to the 0..65535 range DirectInput reports by default, so both
+//          inputs decode identically.
+//-----------------------------------------------------------------------------
+class CGlyphHidTracker : public IGlyphTrackerInput
+{
+public:
+	CGlyphHidTracker()
+	{
+		m_hDevice = INVALID_HANDLE_VALUE;
+		m_hReadEvent = NULL;
+		m_pPreparsedData = NULL;
+		m_unReportLength = 0;
+		m_unButtonCount = 0;
+		m_bReadPending = false;
+		m_bReadFailed = false;
+		m_state = GlyphSample_t();
+		m_unNextSequence = 0;
+		memset(&m_overlapped, 0, sizeof(m_overlapped));
+		memset(m_rgAxes, 0, sizeof(m_rgAxes));
+	}
+
+	virtual ~CGlyphHidTracker()
+	{
+		Stop();
+		Close();
+	}
+
+	virtual const char *GetName() const { return "hid"; }
+
+	virtual bool Open()
+	{
+		GUID hidGuid;
+		HidD_GetHidGuid(&hidGuid);
+
+		HDEVINFO hDevInfo = SetupDiGetClassDevsA(&hidGuid, NULL, NULL, DIGCF_PRESENT | DIGCF_DEVICEINTERFACE);
+		if (hDevInfo == INVALID_HANDLE_VALUE) {
+			DriverLog("Unable to enumerate HID devices: %i\n", GetLastError());
+			return false;
+		}
+
+		SP_DEVICE_INTERFACE_DATA interfaceData;
+		interfaceData.cbSize = sizeof(SP_DEVICE_INTERFACE_DATA);
+		for (DWORD dwIndex = 0; m_hDevice == INVALID_HANDLE_VALUE && SetupDiEnumDeviceInterfaces(hDevInfo, NULL, &hidGuid, dwIndex, &interfaceData); dwIndex++) {
+			DWORD dwRequired = 0;
+			SetupDiGetDeviceInterfaceDetailA(hDevInfo, &interfaceData, NULL, 0, &dwRequired, NULL);
+			if (dwRequired == 0)
+				continue;
+
+			std::vector<char> detailBuffer(dwRequired);
+			SP_DEVICE_INTERFACE_DETAIL_DATA_A *pDetail = (SP_DEVICE_INTERFACE_DETAIL_DATA_A *)&detailBuffer[0];
+			pDetail->cbSize = sizeof(SP_DEVICE_INTERFACE_DETAIL_DATA_A);
+			if (!SetupDiGetDeviceInterfaceDetailA(hDevInfo, &interfaceData, pDetail, dwRequired, NULL, NULL))
+				continue;
+
+			TryOpenPath(pDetail->DevicePath);
+		}
+
+		SetupDiDestroyDeviceInfoList(hDevInfo);
+		return m_hDevice != INVALID_HANDLE_VALUE;
+	}
+
+	virtual bool IsOpen() const { return m_hDevice != INVALID_HANDLE_VALUE; }
+
+	virtual void Close()
+	{
+		if (m_pPreparsedData) {
+			HidD_FreePreparsedData(m_pPreparsedData);
+			m_pPreparsedData = NULL;
+		}
+		if (m_hDevice != INVALID_HANDLE_VALUE) {
+			CloseHandle(m_hDevice);
+			m_hDevice = INVALID_HANDLE_VALUE;
+			ReleasePath(m_sPath);
+			m_sPath.clear();
+		}
+		m_bReadFailed = false;
+	}
+
+	virtual bool IsConnected() const { return m_hDevice != INVALID_HANDLE_VALUE && !m_bReadFailed; }
+
+	virtual uint32_t GetButtonCount() const { return m_hDevice != INVALID_HANDLE_VALUE ? m_unButtonCount : 0; }
+
+	virtual void Start()
+	{
+		if (m_hDevice == INVALID_HANDLE_VALUE)
+			return;
+
+		// manual reset, as overlapped ReadFile requires
+		m_hReadEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+		if (!m_hReadEvent) {
+			DriverLog("Unable to create HID read event: %i\n", GetLastError());
+			return;
+		}
+		m_report.resize(m_unReportLength);
+		IssueRead();
+	}
+
+	virtual void Stop()
+	{
+		if (m_hReadEvent == NULL)
+			return;
+
+		if (m_bReadPending) {
+			DWORD dwBytes;
+			CancelIo(m_hDevice);
+			GetOverlappedResult(m_hDevice, &m_overlapped, &dwBytes, TRUE);
+			m_bReadPending = false;
+		}
+		CloseHandle(m_hReadEvent);
+		m_hReadEvent = NULL;
+	}
+
+	virtual GlyphWaitHandle_t GetWaitHandle() const { return m_hReadEvent; }
+
+	virtual uint32_t ReadSamples(CGlyphSampleHistory *pSamples)
+	{
+		if (m_hReadEvent == NULL || m_bReadFailed)
+			return 0;
+
+		const int64_t nReadTicks = GlyphTicksNow();
+		uint32_t unNewSamples = 0;
+
+		// the HID class driver queues reports, so keep completing reads until one stays pending
+		while (m_bReadPending || IssueRead()) {
+			DWORD dwBytes = 0;
+			if (!GetOverlappedResult(m_hDevice, &m_overlapped, &dwBytes, FALSE)) {
+				DWORD dwError = GetLastError();
+				if (dwError != ERROR_IO_INCOMPLETE) {
+					DriverLog("HID read failed: %i\n", dwError);
+					m_bReadPending = false;
+					m_bReadFailed = true;
+				}
+				break;
+			}
+
+			m_bReadPending = false;
+			if (DecodeReport(dwBytes)) {
+				m_state.unSequence = m_unNextSequence++;
+				m_state.nTimestamp = nReadTicks;
+				pSamples->Push(m_state);
+				unNewSamples++;
+			}
+		}
+
+		return unNewSamples;
+	}
+
+private:
+	struct AxisCaps_t
+	{
+		bool bPresent;
+		USAGE usagePage;
+		USAGE usage;
+		USHORT unLinkCollection;
+		USHORT unBitSize;
+		LONG nLogicalMin;
+		LONG nLogicalMax;
+	};
+
+	void TryOpenPath(const char *pchPath)
+	{
+		HANDLE hDevice = CreateFileA(pchPath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_FLAG_OVERLAPPED, NULL);
+		if (hDevice == INVALID_HANDLE_VALUE)
+			return;
+
+		HIDD_ATTRIBUTES attributes;
+		attributes.Size = sizeof(HIDD_ATTRIBUTES);
+		if (!HidD_GetAttributes(hDevice, &attributes) || attributes.VendorID != k_unGlyphVendorId || attributes.ProductID != k_unGlyphProductId) {
+			CloseHandle(hDevice);
+			return;
+		}
+
+		PHIDP_PREPARSED_DATA pPreparsedData = NULL;
+		if (!HidD_GetPreparsedData(hDevice, &pPreparsedData)) {
+			CloseHandle(hDevice);
+			return;
+		}
+
+		// the tracker can expose several top level collections; use the one carrying the orientation axes
+		if (!ReadAxisCaps(pPreparsedData) || !ClaimPath(pchPath)) {
+			HidD_FreePreparsedData(pPreparsedData);
+			CloseHandle(hDevice);
+			return;
+		}
+
+		m_hDevice = hDevice;
+		m_sPath = pchPath;
+		m_pPreparsedData = pPreparsedData;
+		DriverLog("Glyph HID tracker found: %s (%u byte reports)\n", pchPath, m_unReportLength);
+	}
+
+	bool ReadAxisCaps(PHIDP_PREPARSED_DATA pPreparsedData)
+	{
+		HIDP_CAPS caps;
+		if (HidP_GetCaps(pPreparsedData, &caps) != HIDP_STATUS_SUCCESS || caps.NumberInputValueCaps == 0)
+			return false;
+
+		std::vector<HIDP_VALUE_CAPS> valueCaps(caps.NumberInputValueCaps);
+		USHORT unValueCaps = caps.NumberInputValueCaps;
+		if (HidP_GetValueCaps(HidP_Input, &valueCaps[0], &unValueCaps, pPreparsedData) != HIDP_STATUS_SUCCESS)
+			return false;
+
+		memset(m_rgAxes, 0, sizeof(m_rgAxes));
+		for (USHORT i = 0; i < unValueCaps; i++) {
+			const HIDP_VALUE_CAPS &valueCap = valueCaps[i];
+			if (valueCap.UsagePage != HID_USAGE_PAGE_GENERIC || valueCap.IsRange)
+				continue;
+
+			for (int nAxis = 0; nAxis < GlyphAxis_Count; nAxis++) {
+				AxisCaps_t &axis = m_rgAxes[nAxis];
+				if (axis.bPresent || k_rgAxisUsages[nAxis] != valueCap.NotRange.Usage)
+					continue;
+
+				axis.bPresent = true;
+				axis.usagePage = valueCap.UsagePage;
+				axis.usage = valueCap.NotRange.Usage;
+				axis.unLinkCollection = valueCap.LinkCollection;
+				axis.unBitSize = valueCap.BitSize;
+				axis.nLogicalMin = valueCap.LogicalMin;
+				axis.nLogicalMax = valueCap.LogicalMax;
+
+				// descriptors commonly encode an unsigned 0..2^n-1 range as a negative maximum
+				if (axis.nLogicalMax <= axis.nLogicalMin && axis.nLogicalMin >= 0 && axis.unBitSize < 32)
+					axis.nLogicalMax = (LONG)((1u << axis.unBitSize) - 1);
+				break;
+			}
+		}
+
+		m_unReportLength = caps.InputReportByteLength;
+		ReadButtonCaps(pPreparsedData, caps);
+		return m_rgAxes[GlyphAxis_Y].bPresent && m_rgAxes[GlyphAxis_Z].bPresent && m_rgAxes[GlyphAxis_RX].bPresent;
+	}
+
+	// buttons are usages 1..n of the button page; the count is the highest one
+	void ReadButtonCaps(PHIDP_PREPARSED_DATA pPreparsedData, const HIDP_CAPS &caps)
+	{
+		m_unButtonCount = 0;
+		if (caps.NumberInputButtonCaps == 0)
+			return;
+
+		std::vector<HIDP_BUTTON_CAPS> buttonCaps(caps.NumberInputButtonCaps);
+		USHORT unButtonCaps = caps.NumberInputButtonCaps;
+		if (HidP_GetButtonCaps(HidP_Input, &buttonCaps[0], &unButtonCaps, pPreparsedData) != HIDP_STATUS_SUCCESS)
+			return;
+
+		for (USHORT i = 0; i < unButtonCaps; i++) {
+			const HIDP_BUTTON_CAPS &buttonCap = buttonCaps[i];
+			if (buttonCap.UsagePage != HID_USAGE_PAGE_BUTTON)
+				continue;
+			USAGE usageMax = buttonCap.IsRange ? buttonCap.Range.UsageMax : buttonCap.NotRange.Usage;
+			m_unButtonCount = std::max<uint32_t>(m_unButtonCount, std::min<uint32_t>(usageMax, k_unGlyphMaxButtons));
+		}
+	}
+
+	// returns false if the read could not be queued
+	bool IssueRead()
+	{
+		memset(&m_overlapped, 0, sizeof(m_overlapped));
+		m_overlapped.hEvent = m_hReadEvent;
+
+		if (!ReadFile(m_hDevice, &m_report[0], m_unReportLength, NULL, &m_overlapped)) {
+			DWORD dwError = GetLastError();
+			if (dwError != ERROR_IO_PENDING) {
+				// the tracker is gone; the head tracking thread reopens it
+				DriverLog("HID read could not be queued: %i\n", dwError);
+				m_bReadFailed = true;
+				ResetEvent(m_hReadEvent);
+				return false;
+			}
+		}
+
+		m_bReadPending = true;
+		m_bReadFailed = false;
+		return true;
+	}
+
+	// Update m_state from the report in m_report. Axes the report does not
+	// carry keep their last value.
+	bool DecodeReport(DWORD dwBytes)
+	{
+		bool bDecoded = false;
+		for (int nAxis = 0; nAxis < GlyphAxis_Count; nAxis++) {
+			const AxisCaps_t &axis = m_rgAxes[nAxis];
+			if (!axis.bPresent)
+				continue;
+
+			ULONG ulValue = 0;
+			if (HidP_GetUsageValue(HidP_Input, axis.usagePage, axis.unLinkCollection, axis.usage, &ulValue, m_pPreparsedData, &m_report[0], dwBytes) != HIDP_STATUS_SUCCESS)
+				continue;
+
+			LONG nValue = (LONG)ulValue;
+			if (axis.nLogicalMin < 0 && axis.unBitSize < 32 && (ulValue & (1u << (axis.unBitSize - 1))))
+				nValue = (LONG)(ulValue | ~((1u << axis.unBitSize) - 1));
+
+			int64_t nRange = (int64_t)axis.nLogicalMax - axis.nLogicalMin;
+			if (nRange > 0)
+				m_state.rgnAxis[nAxis] = (int32_t)(((int64_t)nValue - axis.nLogicalMin) * 65535 / nRange);
+			bDecoded = true;
+		}
+
+		// every button held in this report is listed; the rest are up
+		if (m_unButtonCount) {
+			USAGE rgUsages[k_unMaxUsages];
+			ULONG ulUsages = k_unMaxUsages;
+			if (HidP_GetUsages(HidP_Input, HID_USAGE_PAGE_BUTTON, 0, rgUsages, &ulUsages, m_pPreparsedData, &m_report[0], dwBytes) == HIDP_STATUS_SUCCESS) {
+				m_state.unButtons = 0;
+				for (ULONG i = 0; i < ulUsages; i++) {
+					if (rgUsages[i] >= 1 && rgUsages[i] <= k_unGlyphMaxButtons)
+						m_state.unButtons |= 1u << (rgUsages[i] - 1);
+				}
+				bDecoded = true;
+			}
+		}
+		return bDecoded;
+	}
+
+	HANDLE m_hDevice;
+	std::string m_sPath;	// claimed while m_hDevice is open
+	HANDLE m_hReadEvent;
+	PHIDP_PREPARSED_DATA m_pPreparsedData;
+	AxisCaps_t m_rgAxes[GlyphAxis_Count];
+	uint32_t m_unButtonCount;
+	USHORT m_unReportLength;
+
+	OVERLAPPED m_overlapped;
+	std::vector<char> m_report;
+	bool m_bReadPending;
+	bool m_bReadFailed;
+
+	GlyphSample_t m_state;
+	uint32_t m_unNextSequence;
+};
+
+IGlyphTrackerInput *CreateHidTracker()
+{
+	return new CGlyphHidTracker();
+}
@@ -0,0 +1,136 @@
+#include "glyph_input.h"
+#include "glyph_record.h"
+#include "glyph_time.h"
+#include "driverlog.h"
+
+#include <string>
+
+#if !defined( _WINDOWS )
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+//-----------------------------------------------------------------------------
+// Purpose: Feeds a recording made with recordFile back through the tracking
+//          pipeline in place of the live tracker. In real time mode each
+//          sample is released once as much time has passed since Start() as
+//          separated it from the first sample; in max speed mode every
+//          ReadSamples() call releases the next batch at once and the wait
+//          handle stays signalled, so the tracking loop never sleeps.
+//-----------------------------------------------------------------------------
+class CGlyphReplayTracker : public IGlyphTrackerInput
+{
+public:
+	CGlyphReplayTracker(const char *pchPath, bool bRealTime)
+		: m_sPath(pchPath)
+		, m_bRealTime(bRealTime)
+		, m_ulNext(0)
+		, m_nStart(0)
+		, m_hAlwaysSignalled(GLYPH_NO_WAIT_HANDLE)
+	{
+	}
+
+	virtual ~CGlyphReplayTracker()
+	{
+		Stop();
+	}
+
+	virtual const char *GetName() const { return "replay"; }
+
+	virtual bool Open()
+	{
+		if (!m_reader.Open(m_sPath.c_str()))
+			return false;
+
+		DriverLog("Replaying %llu samples from %s at %s\n", m_reader.GetCount(), m_sPath.c_str(), m_bRealTime ? "real time" : "max speed");
+		return true;
+	}
+
+	virtual bool IsOpen() const { return m_reader.IsOpen(); }
+
+	virtual void Close() { m_reader.Close(); }
+
+	// a recording never goes away; at its end the last pose is held
+	virtual bool IsConnected() const { return m_reader.IsOpen(); }
+
+	virtual uint32_t GetButtonCount() const { return m_reader.GetButtonCount(); }
+
+	virtual void Start()
+	{
+		m_ulNext = 0;
+		m_nStart = GlyphTicksNow();
+		if (!m_bRealTime && m_hAlwaysSignalled == GLYPH_NO_WAIT_HANDLE) {
+#if defined( _WINDOWS )
+			m_hAlwaysSignalled = CreateEvent(NULL, TRUE, TRUE, NULL);
+#else
+			// readable for as long as the counter is not read back to zero
+			m_hAlwaysSignalled = eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC);
+#endif
+		}
+	}
+
+	virtual void Stop()
+	{
+		if (m_hAlwaysSignalled != GLYPH_NO_WAIT_HANDLE) {
+#if defined( _WINDOWS )
+			CloseHandle(m_hAlwaysSignalled);
+#else
+			close(m_hAlwaysSignalled);
+#endif
+			m_hAlwaysSignalled = GLYPH_NO_WAIT_HANDLE;
+		}
+	}
+
+	virtual GlyphWaitHandle_t GetWaitHandle() const { return m_hAlwaysSignalled; }
+
+	virtual uint32_t ReadSamples(CGlyphSampleHistory *pSamples)
+	{
+		if (!m_reader.IsOpen() || m_ulNext >= m_reader.GetCount())
+			return 0;
+
+		// in max speed mode, release what fits in the history so none are skipped
+		const int64_t nElapsed = GlyphTicksNow() - m_nStart;
+		const uint32_t unBatch = CGlyphSampleHistory::Capacity() / 2;
+		uint32_t unNewSamples = 0;
+
+		GlyphSample_t sample;
+		while (m_ulNext < m_reader.GetCount()) {
+			m_reader.GetSample(m_ulNext, &sample);
+			if (m_bRealTime ? sample.nTimestamp > nElapsed : unNewSamples >= unBatch)
+				break;
+
+			sample.nTimestamp += m_nStart;
+			pSamples->Push(sample);
+			m_ulNext++;
+			unNewSamples++;
+		}
+
+		if (m_ulNext == m_reader.GetCount() && unNewSamples) {
+			DriverLog("Replay of %s finished after %f s\n", m_sPath.c_str(), GlyphTicksToSeconds(GlyphTicksNow() - m_nStart));
+			// the tracking loop still holds the handle; let it go back to sleeping
+			if (m_hAlwaysSignalled != GLYPH_NO_WAIT_HANDLE) {
+#if defined( _WINDOWS )
+				ResetEvent(m_hAlwaysSignalled);
+#else
+				eventfd_t ulCount;
+				eventfd_read(m_hAlwaysSignalled, &ulCount);
+#endif
+			}
+		}
+		return unNewSamples;
+	}
+
+private:
+	CGlyphRecordingReader m_reader;
+	std::string m_sPath;
+	bool m_bRealTime;
+
+	uint64_t m_ulNext;
+	int64_t m_nStart;
+	GlyphWaitHandle_t m_hAlwaysSignalled;
+};
+
+IGlyphTrackerInput *CreateReplayTracker(const char *pchPath, bool bRealTime)
+{
+	return new CGlyphReplayTracker(pchPath, bRealTime);
+}
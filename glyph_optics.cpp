@@ -0,0 +1,60 @@
+#include "glyph_optics.h"
+
+void GlyphDefaultOptics(GlyphOptics_t *pOptics)
+{
+	for (int i = 0; i < 3; i++) {
+		pOptics->rgflRadial[i] = 0.0f;
+		pOptics->rgflChannelScale[i] = 1.0f;
+	}
+	pOptics->flLensCenterOffset = 0.0f;
+	pOptics->flTanLeft = -1.0f;
+	pOptics->flTanRight = 1.0f;
+	pOptics->flTanTop = -1.0f;
+	pOptics->flTanBottom = 1.0f;
+}
+
+bool GlyphOpticsIsIdentity(const GlyphOptics_t &optics)
+{
+	for (int i = 0; i < 3; i++) {
+		if (optics.rgflRadial[i] != 0.0f || optics.rgflChannelScale[i] != 1.0f)
+			return false;
+	}
+	return optics.flLensCenterOffset == 0.0f;
+}
+
+vr::DistortionCoordinates_t GlyphEvaluateDistortion(const GlyphOptics_t &optics, vr::EVREye eEye, float fU, float fV)
+{
+	// the nose is toward +u for the left eye
+	float flCenterU = 0.5f + (eEye == vr::Eye_Left ? 0.5f : -0.5f) * optics.flLensCenterOffset;
+
+	float x = 2.0f * (fU - flCenterU);
+	float y = 2.0f * (fV - 0.5f);
+	float r2 = x * x + y * y;
+	float flRadial = 1.0f + r2 * (optics.rgflRadial[0] + r2 * (optics.rgflRadial[1] + r2 * optics.rgflRadial[2]));
+
+	float *rgpflChannels[3];
+	vr::DistortionCoordinates_t coordinates;
+	rgpflChannels[0] = coordinates.rfRed;
+	rgpflChannels[1] = coordinates.rfGreen;
+	rgpflChannels[2] = coordinates.rfBlue;
+	for (int i = 0; i < 3; i++) {
+		float flScale = 0.5f * flRadial * optics.rgflChannelScale[i];
+		rgpflChannels[i][0] = flCenterU + x * flScale;
+		rgpflChannels[i][1] = 0.5f + y * flScale;
+	}
+	return coordinates;
+}
+
+void GlyphGetProjection(const GlyphOptics_t &optics, vr::EVREye eEye, float *pfLeft, float *pfRight, float *pfTop, float *pfBottom)
+{
+	if (eEye == vr::Eye_Left) {
+		*pfLeft = optics.flTanLeft;
+		*pfRight = optics.flTanRight;
+	}
+	else {
+		*pfLeft = -optics.flTanRight;
+		*pfRight = -optics.flTanLeft;
+	}
+	*pfTop = optics.flTanTop;
+	*pfBottom = optics.flTanBottom;
+}
@@ -0,0 +1,42 @@
+#ifndef GLYPH_OPTICS_H
+#define GLYPH_OPTICS_H
+
+#pragma once
+
+#include <openvr_driver.h>
+
+#include <stdint.h>
+
+// --------------------------------------------------------------------------
+// Purpose: Lens model of the Glyph's eyepieces. Panel positions are measured
+//          from the lens center in half viewports, so the viewport edges
+//          sit at +-1. A panel point at radius r shows the rendered image
+//          from radius r * (1 + k1 r^2 + k2 r^4 + k3 r^6), scaled again per
+//          color channel for lateral chromatic aberration. The values
+//          describe the left eye; the right eye is its mirror image.
+// --------------------------------------------------------------------------
+struct GlyphOptics_t
+{
+	float rgflRadial[3];		// k1, k2, k3
+	float rgflChannelScale[3];	// red, green, blue
+	float flLensCenterOffset;	// lens center toward the nose, in half viewports
+
+	// projection of the left eye as tangents of the half angles, as GetProjectionRaw reports them
+	float flTanLeft;
+	float flTanRight;
+	float flTanTop;
+	float flTanBottom;
+};
+
+// no distortion and a 90 degree field of view
+extern void GlyphDefaultOptics(GlyphOptics_t *pOptics);
+
+extern bool GlyphOpticsIsIdentity(const GlyphOptics_t &optics);
+
+// the lens model evaluated directly, as ComputeDistortion serves it
+extern vr::DistortionCoordinates_t GlyphEvaluateDistortion(const GlyphOptics_t &optics, vr::EVREye eEye, float fU, float fV);
+
+extern void GlyphGetProjection(const GlyphOptics_t &optics, vr::EVREye eEye, float *pfLeft, float *pfRight, float *pfTop, float *pfBottom);
+
+
+#endif // GLYPH_OPTICS_H
@@ -0,0 +1,240 @@
+#include "glyph_pose.h"
+#include "glyph_time.h"
+
+#include <string.h>
+#include <algorithm>
+
+// velocities below this are reported as sensor noise rather than motion (rad/s)
+static const double k_flMotionThreshold = 0.01;
+
+CGlyphPosePredictor::CGlyphPosePredictor()
+	: m_flVelocityWindow(0.010)
+{
+	Reset();
+}
+
+void CGlyphPosePredictor::Reset()
+{
+	m_unHead = 0;
+	m_unCount = 0;
+	memset(m_vecAngularVelocity, 0, sizeof(m_vecAngularVelocity));
+	memset(m_vecAngularAcceleration, 0, sizeof(m_vecAngularAcceleration));
+}
+
+uint32_t CGlyphPosePredictor::FindWindowStart() const
+{
+	const int64_t nNewest = m_rgHistory[m_unHead].nTimestamp;
+	const int64_t nWindow = GlyphSecondsToTicks(m_flVelocityWindow);
+
+	uint32_t unIndex = m_unHead;
+	for (uint32_t unAge = 1; unAge < m_unCount; unAge++) {
+		unIndex = (m_unHead + k_unHistorySize - unAge) % k_unHistorySize;
+		if (nNewest - m_rgHistory[unIndex].nTimestamp >= nWindow)
+			break;
+	}
+	return unIndex;
+}
+
+void CGlyphPosePredictor::AddSample(const vr::HmdQuaternion_t &qRotation, int64_t nTimestamp)
+{
+	if (m_unCount > 0 && nTimestamp <= m_rgHistory[m_unHead].nTimestamp) {
+		// same report decoded twice, or a clock step; just take the new orientation
+		m_rgHistory[m_unHead].qRotation = qRotation;
+		return;
+	}
+
+	m_unHead = (m_unHead + 1) % k_unHistorySize;
+	if (m_unCount < k_unHistorySize)
+		m_unCount++;
+
+	History_t &newest = m_rgHistory[m_unHead];
+	newest.nTimestamp = nTimestamp;
+	newest.qRotation = qRotation;
+	memset(newest.vecAngularVelocity, 0, sizeof(newest.vecAngularVelocity));
+
+	if (m_unCount < 2) {
+		memset(m_vecAngularVelocity, 0, sizeof(m_vecAngularVelocity));
+		memset(m_vecAngularAcceleration, 0, sizeof(m_vecAngularAcceleration));
+		return;
+	}
+
+	const History_t &start = m_rgHistory[FindWindowStart()];
+	double dt = GlyphTicksToSeconds(nTimestamp - start.nTimestamp);
+
+	// world frame delta: qRotation = qDelta * start.qRotation
+	double vecDelta[3];
+	HmdQuaternion_ToRotationVector(HmdQuaternion_Multiply(qRotation, HmdQuaternion_Conjugate(start.qRotation)), vecDelta);
+
+	// the difference is the velocity at the middle of the window; history keeps
+	// that, and the reported velocity is advanced to the newest sample
+	for (int i = 0; i < 3; i++) {
+		newest.vecAngularVelocity[i] = vecDelta[i] / dt;
+		m_vecAngularAcceleration[i] = (newest.vecAngularVelocity[i] - start.vecAngularVelocity[i]) / dt;
+		m_vecAngularVelocity[i] = newest.vecAngularVelocity[i] + 0.5 * dt * m_vecAngularAcceleration[i];
+	}
+}
+
+bool CGlyphPosePredictor::IsMoving() const
+{
+	double speedSquared = m_vecAngularVelocity[0] * m_vecAngularVelocity[0]
+		+ m_vecAngularVelocity[1] * m_vecAngularVelocity[1]
+		+ m_vecAngularVelocity[2] * m_vecAngularVelocity[2];
+	return speedSquared > k_flMotionThreshold * k_flMotionThreshold;
+}
+
+vr::HmdQuaternion_t CGlyphPosePredictor::Extrapolate(const vr::HmdQuaternion_t &qRotation, double flSeconds) const
+{
+	if (flSeconds == 0.0)
+		return qRotation;
+
+	double vecRotation[3];
+	for (int i = 0; i < 3; i++)
+		vecRotation[i] = m_vecAngularVelocity[i] * flSeconds + 0.5 * m_vecAngularAcceleration[i] * flSeconds * flSeconds;
+
+	return HmdQuaternion_Multiply(HmdQuaternion_FromRotationVector(vecRotation), qRotation);
+}
+
+
+// reports closer together than this are treated as this far apart, so a
+// batch stamped with one DirectInput tick still moves the filter
+static const double k_flMinFilterInterval = 0.001;
+
+// smoothing factor of a first order low pass at flCutoff Hz over dt seconds
+static double LowPassAlpha(double dt, double flCutoff)
+{
+	double flTau = 1.0 / (2.0 * 3.14159265358979323846 * flCutoff);
+	return 1.0 / (1.0 + flTau / dt);
+}
+
+CGlyphOrientationFilter::CGlyphOrientationFilter()
+	: m_flMinCutoff(0.0)
+	, m_bHaveSample(false)
+	, m_flFilteredSpeed(0.0)
+	, m_nLastTimestamp(0)
+{
+	Configure(0.0, 0.0, 1.0);
+}
+
+void CGlyphOrientationFilter::Configure(double flMinCutoff, double flBeta, double flDerivativeCutoff)
+{
+	// output held from before the filter was switched off is stale
+	if (flMinCutoff > 0 && m_flMinCutoff <= 0)
+		m_bHaveSample = false;
+
+	m_flMinCutoff = flMinCutoff;
+	m_flBeta = flBeta;
+	m_flDerivativeCutoff = flDerivativeCutoff > 0 ? flDerivativeCutoff : 1.0;
+}
+
+vr::HmdQuaternion_t CGlyphOrientationFilter::Filter(const vr::HmdQuaternion_t &qRotation, int64_t nTimestamp)
+{
+	if (!IsEnabled())
+		return qRotation;
+
+	if (!m_bHaveSample) {
+		m_bHaveSample = true;
+		m_qFiltered = qRotation;
+		m_flFilteredSpeed = 0.0;
+		m_nLastTimestamp = nTimestamp;
+		return qRotation;
+	}
+
+	double dt = std::max<double>(GlyphTicksToSeconds(nTimestamp - m_nLastTimestamp), k_flMinFilterInterval);
+	m_nLastTimestamp = nTimestamp;
+
+	// q and -q are the same rotation; lerp toward whichever is nearer
+	double flDot = m_qFiltered.w * qRotation.w + m_qFiltered.x * qRotation.x + m_qFiltered.y * qRotation.y + m_qFiltered.z * qRotation.z;
+	double flSign = flDot < 0 ? -1.0 : 1.0;
+	flDot *= flSign;
+
+	// angle between them is 2 acos(dot); 2 sqrt(1 - dot^2) is its sine form, close enough at these step sizes
+	double flAngle = 2.0 * sqrt(std::max<double>(0.0, 1.0 - flDot * flDot));
+	m_flFilteredSpeed += LowPassAlpha(dt, m_flDerivativeCutoff) * (flAngle / dt - m_flFilteredSpeed);
+
+	double flAlpha = LowPassAlpha(dt, m_flMinCutoff + m_flBeta * m_flFilteredSpeed);
+	double w = m_qFiltered.w + flAlpha * (flSign * qRotation.w - m_qFiltered.w);
+	double x = m_qFiltered.x + flAlpha * (flSign * qRotation.x - m_qFiltered.x);
+	double y = m_qFiltered.y + flAlpha * (flSign * qRotation.y - m_qFiltered.y);
+	double z = m_qFiltered.z + flAlpha * (flSign * qRotation.z - m_qFiltered.z);
+	double flInvLength = 1.0 / sqrt(w * w + x * x + y * y + z * z);
+
+	m_qFiltered = HmdQuaternion_Init(w * flInvLength, x * flInvLength, y * flInvLength, z * flInvLength);
+	return m_qFiltered;
+}
+
+
+CGlyphPublishThrottle::CGlyphPublishThrottle()
+	: m_flMinHalfAngleCos(1.0)
+	, m_nMinInterval(0)
+	, m_nMaxInterval(0)
+	, m_qPublished(HmdQuaternion_Init(1, 0, 0, 0))
+	, m_nLastPublish(0)
+	, m_bPending(false)
+	, m_nCurrentSlot(-1)
+	, m_nNextSlot(-1)
+	, m_ulPublished(0)
+	, m_ulSuppressed(0)
+{
+}
+
+void CGlyphPublishThrottle::Configure(double flMinAngle, double flMinInterval, double flMaxInterval)
+{
+	m_flMinHalfAngleCos = cos(0.5 * flMinAngle);
+	m_nMinInterval = GlyphSecondsToTicks(flMinInterval);
+	m_nMaxInterval = GlyphSecondsToTicks(flMaxInterval);
+}
+
+bool CGlyphPublishThrottle::Update(const vr::HmdQuaternion_t &qRotation, bool bChanged, bool bForce, int64_t nNow)
+{
+	if (bForce) {
+		m_bPending = true;
+	}
+	else if (bChanged && !m_bPending) {
+		// |dot| is the cosine of half the angle between the two orientations
+		double dot = fabs(qRotation.w * m_qPublished.w + qRotation.x * m_qPublished.x + qRotation.y * m_qPublished.y + qRotation.z * m_qPublished.z);
+		m_bPending = dot < m_flMinHalfAngleCos;
+	}
+
+	int64_t nSincePublish = nNow - m_nLastPublish;
+	bool bSlotOpen = m_nCurrentSlot < 0 || m_nLastPublish < m_nCurrentSlot;
+	bool bDue = (m_bPending && bSlotOpen && nSincePublish >= m_nMinInterval) || (m_nMaxInterval > 0 && nSincePublish >= m_nMaxInterval);
+
+	if (bChanged && !bDue)
+		m_ulSuppressed++;
+
+	return bDue;
+}
+
+void CGlyphPublishThrottle::OnPublished(const vr::HmdQuaternion_t &qRotation, int64_t nNow)
+{
+	m_qPublished = qRotation;
+	m_nLastPublish = nNow;
+	m_bPending = false;
+	m_ulPublished++;
+}
+
+void CGlyphPublishThrottle::SetSlot(int64_t nCurrentSlot, int64_t nNextSlot)
+{
+	m_nCurrentSlot = nCurrentSlot;
+	m_nNextSlot = nNextSlot;
+}
+
+int64_t CGlyphPublishThrottle::TicksUntilDue(int64_t nNow) const
+{
+	int64_t nSincePublish = nNow - m_nLastPublish;
+	int64_t nUntil = -1;
+
+	if (m_bPending) {
+		nUntil = std::max<int64_t>(0, m_nMinInterval - nSincePublish);
+		if (m_nCurrentSlot >= 0 && m_nLastPublish >= m_nCurrentSlot)
+			nUntil = std::max<int64_t>(nUntil, m_nNextSlot - nNow);
+	}
+
+	if (m_nMaxInterval > 0) {
+		int64_t nKeepAlive = std::max<int64_t>(0, m_nMaxInterval - nSincePublish);
+		if (nUntil < 0 || nKeepAlive < nUntil)
+			nUntil = nKeepAlive;
+	}
+
+	return nUntil;
+}
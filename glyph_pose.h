@@ -0,0 +1,239 @@
+#ifndef GLYPH_POSE_H
+#define GLYPH_POSE_H
+
+#pragma once
+
+#include <openvr_driver.h>
+
+#include <stdint.h>
+#include <cmath>
+
+inline vr::HmdQuaternion_t HmdQuaternion_Init(double w, double x, double y, double z)
+{
+	vr::HmdQuaternion_t quat;
+	quat.w = w;
+	quat.x = x;
+	quat.y = y;
+	quat.z = z;
+	return quat;
+}
+
+inline vr::HmdQuaternion_t HmdQuaternion_Multiply(const vr::HmdQuaternion_t &a, const vr::HmdQuaternion_t &b)
+{
+	return HmdQuaternion_Init(
+		a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+		a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+		a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+		a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w);
+}
+
+inline vr::HmdQuaternion_t HmdQuaternion_Conjugate(const vr::HmdQuaternion_t &q)
+{
+	return HmdQuaternion_Init(q.w, -q.x, -q.y, -q.z);
+}
+
+// --------------------------------------------------------------------------
+// Purpose: Head rotation from Euler half angles (radians): roll about Z, then
+//          pitch about X, then yaw about Y, i.e. qYaw * qPitch * qRoll. Each
+//          sin/cos is evaluated once.
+// --------------------------------------------------------------------------
+inline vr::HmdQuaternion_t HmdQuaternion_FromEulerHalfAngles(double halfPitch, double halfYaw, double halfRoll)
+{
+	double sp = sin(halfPitch), cp = cos(halfPitch);
+	double sy = sin(halfYaw), cy = cos(halfYaw);
+	double sr = sin(halfRoll), cr = cos(halfRoll);
+
+	return HmdQuaternion_Init(
+		cy * cp * cr + sy * sp * sr,
+		cy * sp * cr + sy * cp * sr,
+		sy * cp * cr - cy * sp * sr,
+		cy * cp * sr - sy * sp * cr);
+}
+
+inline vr::HmdQuaternion_t HmdQuaternion_FromEuler(double pitch, double yaw, double roll)
+{
+	return HmdQuaternion_FromEulerHalfAngles(0.5 * pitch, 0.5 * yaw, 0.5 * roll);
+}
+
+// --------------------------------------------------------------------------
+// Purpose: Head rotation from raw tracker axes. lZ is pitch, lRx yaw and
+//          -lY roll; each spans a full turn over 0..65535 and is offset by
+//          half a turn so the middle of the range faces forward. Works in
+//          half angles directly rather than going through degrees.
+// --------------------------------------------------------------------------
+static const double k_flGlyphAxisToHalfAngle = 3.14159265358979323846 / 65535.0;
+static const double k_flGlyphHalfAngleOffset = 0.5 * 3.14159265358979323846;
+
+inline vr::HmdQuaternion_t GlyphAxesToRotation(int32_t nPitchAxis, int32_t nYawAxis, int32_t nRollAxis)
+{
+	return HmdQuaternion_FromEulerHalfAngles(
+		k_flGlyphAxisToHalfAngle * nPitchAxis + k_flGlyphHalfAngleOffset,
+		k_flGlyphAxisToHalfAngle * nYawAxis + k_flGlyphHalfAngleOffset,
+		-k_flGlyphAxisToHalfAngle * nRollAxis + k_flGlyphHalfAngleOffset);
+}
+
+// --------------------------------------------------------------------------
+// Purpose: Rotation vector (axis * angle in radians) of a unit quaternion,
+//          taking the short way around
+// --------------------------------------------------------------------------
+inline void HmdQuaternion_ToRotationVector(const vr::HmdQuaternion_t &q, double *pvecRotation)
+{
+	double sign = q.w < 0 ? -1.0 : 1.0;
+	double sinHalf = sqrt(q.x * q.x + q.y * q.y + q.z * q.z);
+
+	// angle / sin(angle / 2) tends to 2 for small angles
+	double scale = 2.0;
+	if (sinHalf > 1e-9)
+		scale = 2.0 * atan2(sinHalf, sign * q.w) / sinHalf;
+
+	pvecRotation[0] = sign * scale * q.x;
+	pvecRotation[1] = sign * scale * q.y;
+	pvecRotation[2] = sign * scale * q.z;
+}
+
+inline vr::HmdQuaternion_t HmdQuaternion_FromRotationVector(const double *pvecRotation)
+{
+	double angle = sqrt(pvecRotation[0] * pvecRotation[0] + pvecRotation[1] * pvecRotation[1] + pvecRotation[2] * pvecRotation[2]);
+	if (angle < 1e-9)
+		return HmdQuaternion_Init(1, 0.5 * pvecRotation[0], 0.5 * pvecRotation[1], 0.5 * pvecRotation[2]);
+
+	double scale = sin(0.5 * angle) / angle;
+	return HmdQuaternion_Init(cos(0.5 * angle), scale * pvecRotation[0], scale * pvecRotation[1], scale * pvecRotation[2]);
+}
+
+// --------------------------------------------------------------------------
+// Purpose: Estimates angular velocity and acceleration from the decoded
+//          orientation stream and extrapolates orientation forward in time.
+//          Velocities are rotation vectors in the driver frame, in rad/s
+//          and rad/s^2. Single threaded; owned by the tracking thread.
+// --------------------------------------------------------------------------
+class CGlyphPosePredictor
+{
+public:
+	CGlyphPosePredictor();
+
+	void Reset();
+
+	// Differences are taken across at least flWindow seconds of history so
+	// that axis quantization does not turn into velocity noise.
+	void SetVelocityWindow(double flWindow) { m_flVelocityWindow = flWindow; }
+	double GetVelocityWindow() const { return m_flVelocityWindow; }
+
+	// feed each decoded orientation in sample order; nTimestamp in GlyphTicksNow() units
+	void AddSample(const vr::HmdQuaternion_t &qRotation, int64_t nTimestamp);
+
+	const double *GetAngularVelocity() const { return m_vecAngularVelocity; }
+	const double *GetAngularAcceleration() const { return m_vecAngularAcceleration; }
+	bool IsMoving() const;
+
+	// orientation flSeconds after the newest sample
+	vr::HmdQuaternion_t Extrapolate(const vr::HmdQuaternion_t &qRotation, double flSeconds) const;
+
+private:
+	struct History_t
+	{
+		int64_t nTimestamp;
+		vr::HmdQuaternion_t qRotation;
+		double vecAngularVelocity[3];
+	};
+
+	// index of the newest entry at least m_flVelocityWindow older than the newest, or the oldest entry
+	uint32_t FindWindowStart() const;
+
+	static const uint32_t k_unHistorySize = 32;
+	History_t m_rgHistory[k_unHistorySize];
+	uint32_t m_unHead;
+	uint32_t m_unCount;
+
+	double m_flVelocityWindow;
+	double m_vecAngularVelocity[3];
+	double m_vecAngularAcceleration[3];
+};
+
+// --------------------------------------------------------------------------
+// Purpose: One euro filter on the orientation stream. Each sample moves the
+//          output toward the new orientation by a fraction set by a cutoff
+//          frequency that rises with the filtered angular speed, so a head
+//          held still is smoothed heavily and a turning one barely at all.
+//          The update is a dot product, a normalized lerp and a few divides,
+//          with no trigonometry. Single threaded; owned by the tracking thread.
+// --------------------------------------------------------------------------
+class CGlyphOrientationFilter
+{
+public:
+	CGlyphOrientationFilter();
+
+	// Cutoffs in Hz; flBeta in Hz per rad/s of speed. A minimum cutoff of 0
+	// disables the filter and samples pass through unchanged.
+	void Configure(double flMinCutoff, double flBeta, double flDerivativeCutoff);
+	bool IsEnabled() const { return m_flMinCutoff > 0; }
+
+	// the next sample passes through and starts the filter over
+	void Reset() { m_bHaveSample = false; }
+
+	// filtered orientation for a sample; nTimestamp in GlyphTicksNow() units
+	vr::HmdQuaternion_t Filter(const vr::HmdQuaternion_t &qRotation, int64_t nTimestamp);
+
+private:
+	double m_flMinCutoff;
+	double m_flBeta;
+	double m_flDerivativeCutoff;
+
+	bool m_bHaveSample;
+	vr::HmdQuaternion_t m_qFiltered;
+	double m_flFilteredSpeed;		// rad/s
+	int64_t m_nLastTimestamp;
+};
+
+// --------------------------------------------------------------------------
+// Purpose: Decides when the tracking thread sends a pose to vrserver. A pose
+//          goes out once it has turned at least the minimum angle from the
+//          last one sent, or when the keep-alive interval runs out, but never
+//          sooner than the minimum interval after the previous publish.
+//          Changes held back by the rate cap are sent once it allows.
+// --------------------------------------------------------------------------
+class CGlyphPublishThrottle
+{
+public:
+	CGlyphPublishThrottle();
+
+	// flMinAngle in radians; intervals in seconds, 0 disables that limit
+	void Configure(double flMinAngle, double flMinInterval, double flMaxInterval);
+
+	// Call on every tracking loop iteration with the current orientation.
+	// bChanged marks a newly decoded pose, bForce one that must reach
+	// vrserver even if it has not turned, e.g. motion stopping. Returns true
+	// if the pose should be published now; the caller then calls OnPublished().
+	bool Update(const vr::HmdQuaternion_t &qRotation, bool bChanged, bool bForce, int64_t nNow);
+	void OnPublished(const vr::HmdQuaternion_t &qRotation, int64_t nNow);
+
+	// Optionally gate changes to one publish per frame slot: nCurrentSlot is
+	// the latest slot start at or before now, nNextSlot the one after it. A
+	// change goes out at the first opportunity after a slot starts.
+	void SetSlot(int64_t nCurrentSlot, int64_t nNextSlot);
+	void ClearSlot() { m_nCurrentSlot = m_nNextSlot = -1; }
+
+	// ticks until Update() would next return true with no new data, or -1 if never
+	int64_t TicksUntilDue(int64_t nNow) const;
+
+	uint64_t GetPublishedCount() const { return m_ulPublished; }
+	uint64_t GetSuppressedCount() const { return m_ulSuppressed; }
+
+private:
+	double m_flMinHalfAngleCos;
+	int64_t m_nMinInterval;
+	int64_t m_nMaxInterval;
+
+	vr::HmdQuaternion_t m_qPublished;
+	int64_t m_nLastPublish;
+	bool m_bPending;
+
+	int64_t m_nCurrentSlot;
+	int64_t m_nNextSlot;
+
+	uint64_t m_ulPublished;
+	uint64_t m_ulSuppressed;
+};
+
+
+#endif // GLYPH_POSE_H
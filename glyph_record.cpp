@@ -0,0 +1,263 @@
+#include "glyph_record.h"
+#include "glyph_time.h"
+#include "driverlog.h"
+
+#include <string.h>
+#include <chrono>
+
+#if defined( _WIN32 )
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// how often the writer thread wakes to move the ring to the file
+static const uint32_t k_unRecordFlushIntervalMs = 20;
+
+static uint16_t ClampAxis(int32_t nValue)
+{
+	return nValue < 0 ? 0 : nValue > 65535 ? 65535 : (uint16_t)nValue;
+}
+
+
+CGlyphSampleRecorder::CGlyphSampleRecorder()
+	: m_unHead(0)
+	, m_unTail(0)
+	, m_pFile(NULL)
+	, m_pWriterThread(NULL)
+	, m_bRunning(false)
+	, m_ulWritten(0)
+	, m_ulDropped(0)
+{
+}
+
+CGlyphSampleRecorder::~CGlyphSampleRecorder()
+{
+	Close();
+}
+
+bool CGlyphSampleRecorder::Open(const char *pchPath, uint32_t unButtonCount)
+{
+	if (m_pFile)
+		return false;
+
+#if defined( _WIN32 )
+	if (fopen_s(&m_pFile, pchPath, "wb") != 0)
+		m_pFile = NULL;
+#else
+	m_pFile = fopen(pchPath, "wb");
+#endif
+	if (!m_pFile) {
+		DriverLog("Unable to create recording %s\n", pchPath);
+		return false;
+	}
+
+	GlyphRecordHeader_t header;
+	memcpy(header.rgchMagic, k_rgchGlyphRecordMagic, sizeof(header.rgchMagic));
+	header.unVersion = k_unGlyphRecordVersion;
+	header.unRecordSize = sizeof(GlyphRecord_t);
+	header.unAxisCount = GlyphAxis_Count;
+	header.nTicksPerSecond = GlyphTicksPerSecond();
+	header.unButtonCount = unButtonCount;
+	fwrite(&header, sizeof(header), 1, m_pFile);
+
+	m_unHead = 0;
+	m_unTail = 0;
+	m_ulWritten = 0;
+	m_ulDropped = 0;
+	m_bRunning = true;
+	m_pWriterThread = new std::thread(&CGlyphSampleRecorder::WriterThread, this);
+
+	DriverLog("Recording tracker samples to %s\n", pchPath);
+	return true;
+}
+
+void CGlyphSampleRecorder::Close()
+{
+	if (!m_pFile)
+		return;
+
+	m_bRunning = false;
+	if (m_pWriterThread) {
+		m_pWriterThread->join();
+		delete m_pWriterThread;
+		m_pWriterThread = NULL;
+	}
+
+	fclose(m_pFile);
+	m_pFile = NULL;
+	DriverLog("Recording closed: %llu samples written, %llu dropped\n", m_ulWritten, GetDroppedCount());
+}
+
+void CGlyphSampleRecorder::Append(const GlyphSample_t &sample)
+{
+	uint32_t unHead = m_unHead.load(std::memory_order_relaxed);
+	if (unHead - m_unTail.load(std::memory_order_acquire) >= k_unRingSize) {
+		m_ulDropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	GlyphRecord_t &record = m_rgRing[unHead & (k_unRingSize - 1)];
+	record.nTimestamp = sample.nTimestamp;
+	record.unSequence = sample.unSequence;
+	for (int i = 0; i < GlyphAxis_Count; i++)
+		record.rgunAxis[i] = ClampAxis(sample.rgnAxis[i]);
+	record.unButtons = sample.unButtons;
+
+	m_unHead.store(unHead + 1, std::memory_order_release);
+}
+
+void CGlyphSampleRecorder::Drain()
+{
+	uint32_t unTail = m_unTail.load(std::memory_order_relaxed);
+	uint32_t unHead = m_unHead.load(std::memory_order_acquire);
+
+	while (unTail != unHead) {
+		// the filled part of the ring may wrap, so write it in at most two runs
+		uint32_t unStart = unTail & (k_unRingSize - 1);
+		uint32_t unRun = unHead - unTail;
+		if (unRun > k_unRingSize - unStart)
+			unRun = k_unRingSize - unStart;
+
+		fwrite(&m_rgRing[unStart], sizeof(GlyphRecord_t), unRun, m_pFile);
+		unTail += unRun;
+		m_ulWritten += unRun;
+		m_unTail.store(unTail, std::memory_order_release);
+	}
+}
+
+void CGlyphSampleRecorder::WriterThread()
+{
+	while (m_bRunning) {
+		Drain();
+		std::this_thread::sleep_for(std::chrono::milliseconds(k_unRecordFlushIntervalMs));
+	}
+	Drain();
+	fflush(m_pFile);
+}
+
+
+CGlyphRecordingReader::CGlyphRecordingReader()
+	: m_pView(NULL)
+	, m_pRecords(NULL)
+	, m_ulCount(0)
+	, m_unButtonCount(0)
+	, m_unViewSize(0)
+	, m_flTickScale(1.0)
+	, m_nFirstTimestamp(0)
+#if defined( _WIN32 )
+	, m_hFile(INVALID_HANDLE_VALUE)
+	, m_hMapping(NULL)
+#else
+	, m_nFile(-1)
+#endif
+{
+}
+
+CGlyphRecordingReader::~CGlyphRecordingReader()
+{
+	Close();
+}
+
+bool CGlyphRecordingReader::Open(const char *pchPath)
+{
+	Close();
+
+#if defined( _WIN32 )
+	m_hFile = CreateFileA(pchPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (m_hFile == INVALID_HANDLE_VALUE) {
+		DriverLog("Unable to open recording %s: %i\n", pchPath, GetLastError());
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(m_hFile, &fileSize) || fileSize.QuadPart < (LONGLONG)sizeof(GlyphRecordHeader_t) || (uint64_t)fileSize.QuadPart > (size_t)-1) {
+		DriverLog("Recording %s is empty or too large to map\n", pchPath);
+		Close();
+		return false;
+	}
+	m_unViewSize = (size_t)fileSize.QuadPart;
+
+	m_hMapping = CreateFileMappingA(m_hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (m_hMapping) {
+		m_pView = (const uint8_t *)MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0);
+	}
+#else
+	m_nFile = open(pchPath, O_RDONLY);
+	if (m_nFile < 0) {
+		DriverLog("Unable to open recording %s\n", pchPath);
+		return false;
+	}
+
+	struct stat fileStat;
+	if (fstat(m_nFile, &fileStat) != 0 || fileStat.st_size < (off_t)sizeof(GlyphRecordHeader_t)) {
+		DriverLog("Recording %s is empty\n", pchPath);
+		Close();
+		return false;
+	}
+	m_unViewSize = (size_t)fileStat.st_size;
+
+	void *pView = mmap(NULL, m_unViewSize, PROT_READ, MAP_PRIVATE, m_nFile, 0);
+	m_pView = pView == MAP_FAILED ? NULL : (const uint8_t *)pView;
+#endif
+
+	if (!m_pView) {
+		DriverLog("Unable to map recording %s\n", pchPath);
+		Close();
+		return false;
+	}
+
+	const GlyphRecordHeader_t *pHeader = (const GlyphRecordHeader_t *)m_pView;
+	if (memcmp(pHeader->rgchMagic, k_rgchGlyphRecordMagic, sizeof(pHeader->rgchMagic)) || pHeader->unVersion != k_unGlyphRecordVersion
+		|| pHeader->unRecordSize != sizeof(GlyphRecord_t) || pHeader->unAxisCount != GlyphAxis_Count || pHeader->nTicksPerSecond <= 0) {
+		DriverLog("%s is not a version %u tracker recording\n", pchPath, k_unGlyphRecordVersion);
+		Close();
+		return false;
+	}
+
+	m_flTickScale = (double)GlyphTicksPerSecond() / (double)pHeader->nTicksPerSecond;
+	m_ulCount = (m_unViewSize - sizeof(GlyphRecordHeader_t)) / sizeof(GlyphRecord_t);
+	m_unButtonCount = pHeader->unButtonCount < k_unGlyphMaxButtons ? pHeader->unButtonCount : k_unGlyphMaxButtons;
+	m_pRecords = (const GlyphRecord_t *)(m_pView + sizeof(GlyphRecordHeader_t));
+	m_nFirstTimestamp = m_ulCount ? m_pRecords[0].nTimestamp : 0;
+	return true;
+}
+
+void CGlyphRecordingReader::Close()
+{
+#if defined( _WIN32 )
+	if (m_pView)
+		UnmapViewOfFile(m_pView);
+	if (m_hMapping)
+		CloseHandle(m_hMapping);
+	if (m_hFile != INVALID_HANDLE_VALUE)
+		CloseHandle(m_hFile);
+	m_hMapping = NULL;
+	m_hFile = INVALID_HANDLE_VALUE;
+#else
+	if (m_pView)
+		munmap((void *)m_pView, m_unViewSize);
+	if (m_nFile >= 0)
+		close(m_nFile);
+	m_nFile = -1;
+#endif
+
+	m_pView = NULL;
+	m_pRecords = NULL;
+	m_ulCount = 0;
+	m_unButtonCount = 0;
+	m_unViewSize = 0;
+}
+
+void CGlyphRecordingReader::GetSample(uint64_t ulIndex, GlyphSample_t *pSample) const
+{
+	const GlyphRecord_t &record = m_pRecords[ulIndex];
+	pSample->unSequence = record.unSequence;
+	pSample->nTimestamp = (int64_t)((record.nTimestamp - m_nFirstTimestamp) * m_flTickScale);
+	for (int i = 0; i < GlyphAxis_Count; i++)
+		pSample->rgnAxis[i] = record.rgunAxis[i];
+	pSample->unButtons = record.unButtons;
+}
@@ -0,0 +1,126 @@
+#ifndef GLYPH_RECORD_H
+#define GLYPH_RECORD_H
+
+#pragma once
+
+#include "glyph_sample.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+
+// --------------------------------------------------------------------------
+// Recording file format: a GlyphRecordHeader_t followed by one
+// GlyphRecord_t per tracker report, little endian, no padding. Axes are
+// stored in 16 bits since both inputs report them over 0..65535; anything
+// outside that range is clamped. Version 2 added the buttons.
+// --------------------------------------------------------------------------
+static const char k_rgchGlyphRecordMagic[4] = { 'G', 'L', 'Y', 'R' };
+static const uint32_t k_unGlyphRecordVersion = 2;
+
+#pragma pack(push, 1)
+struct GlyphRecordHeader_t
+{
+	char rgchMagic[4];
+	uint32_t unVersion;
+	uint32_t unRecordSize;		// sizeof(GlyphRecord_t)
+	uint32_t unAxisCount;		// GlyphAxis_Count
+	int64_t nTicksPerSecond;	// unit of GlyphRecord_t::nTimestamp
+	uint32_t unButtonCount;		// buttons the tracker had
+};
+
+struct GlyphRecord_t
+{
+	int64_t nTimestamp;			// GlyphTicksNow() time on the recording machine
+	uint32_t unSequence;
+	uint16_t rgunAxis[GlyphAxis_Count];
+	uint32_t unButtons;
+};
+#pragma pack(pop)
+
+// --------------------------------------------------------------------------
+// Purpose: Appends tracker samples to a recording. Append() only copies the
+//          sample into a lock-free single producer ring; a writer thread
+//          does the file I/O. If the writer falls behind, samples are
+//          dropped and counted rather than stalling the tracking thread.
+// --------------------------------------------------------------------------
+class CGlyphSampleRecorder
+{
+public:
+	CGlyphSampleRecorder();
+	~CGlyphSampleRecorder();
+
+	bool Open(const char *pchPath, uint32_t unButtonCount);
+	void Close();
+	bool IsOpen() const { return m_pFile != NULL; }
+
+	// tracking thread only
+	void Append(const GlyphSample_t &sample);
+
+	uint64_t GetWrittenCount() const { return m_ulWritten; }
+	uint64_t GetDroppedCount() const { return m_ulDropped.load(std::memory_order_relaxed); }
+
+private:
+	void WriterThread();
+	void Drain();
+
+	static const uint32_t k_unRingSize = 4096;	// must be a power of two
+	GlyphRecord_t m_rgRing[k_unRingSize];
+	std::atomic<uint32_t> m_unHead;		// next slot Append() fills
+	std::atomic<uint32_t> m_unTail;		// next slot the writer takes
+
+	FILE *m_pFile;
+	std::thread *m_pWriterThread;
+	std::atomic<bool> m_bRunning;
+
+	uint64_t m_ulWritten;
+	std::atomic<uint64_t> m_ulDropped;
+
+	CGlyphSampleRecorder(const CGlyphSampleRecorder &);
+	CGlyphSampleRecorder &operator=(const CGlyphSampleRecorder &);
+};
+
+// --------------------------------------------------------------------------
+// Purpose: Read only, memory-mapped view of a recording, so long captures
+//          are paged in as they are replayed rather than loaded up front
+// --------------------------------------------------------------------------
+class CGlyphRecordingReader
+{
+public:
+	CGlyphRecordingReader();
+	~CGlyphRecordingReader();
+
+	bool Open(const char *pchPath);
+	void Close();
+	bool IsOpen() const { return m_pRecords != NULL; }
+
+	uint64_t GetCount() const { return m_ulCount; }
+	uint32_t GetButtonCount() const { return m_unButtonCount; }
+
+	// Sample unIndex with its timestamp converted to GlyphTicksNow() units and
+	// measured from the first sample of the recording
+	void GetSample(uint64_t ulIndex, GlyphSample_t *pSample) const;
+
+private:
+	const uint8_t *m_pView;
+	const GlyphRecord_t *m_pRecords;
+	uint64_t m_ulCount;
+	uint32_t m_unButtonCount;
+	size_t m_unViewSize;
+	double m_flTickScale;		// local ticks per recorded tick
+	int64_t m_nFirstTimestamp;
+
+#if defined( _WIN32 )
+	void *m_hFile;
+	void *m_hMapping;
+#else
+	int m_nFile;
+#endif
+
+	CGlyphRecordingReader(const CGlyphRecordingReader &);
+	CGlyphRecordingReader &operator=(const CGlyphRecordingReader &);
+};
+
+
+#endif // GLYPH_RECORD_H
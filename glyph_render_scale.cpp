@@ -0,0 +1,103 @@
+#include "glyph_render_scale.h"
+
+#include <cmath>
+#include <algorithm>
+
+const float CGlyphRenderScaler::k_flScaleStep = 0.05f;
+
+// frames averaged before each decision, about a second at the Glyph's refresh rates
+static const uint32_t k_unWindowFrames = 60;
+
+// fractions of the frame budget: above the first the scale shrinks, below
+// the second it may grow, and shrinking aims for the third
+static const double k_flOverBudget = 0.9;
+static const double k_flUnderBudget = 0.6;
+static const double k_flTargetBudget = 0.75;
+
+// dropped frames tolerated per window before the scale shrinks
+static const uint32_t k_unMaxDroppedPerWindow = 1;
+
+static const uint32_t k_unHeadroomWindowsToGrow = 3;
+static const uint32_t k_unHoldWindowsAfterChange = 2;
+
+CGlyphRenderScaler::CGlyphRenderScaler()
+{
+	Configure(1.0f, 1.0f, 1.0f);
+}
+
+void CGlyphRenderScaler::Configure(float flInitialScale, float flMinScale, float flMaxScale)
+{
+	m_flMinScale = std::min<float>(flMinScale, flMaxScale);
+	m_flMaxScale = std::max<float>(flMinScale, flMaxScale);
+	m_flScale = std::min<float>(std::max<float>(Quantize(flInitialScale), m_flMinScale), m_flMaxScale);
+
+	m_unWindowFrames = 0;
+	m_flWindowGpuMs = 0.0;
+	m_unWindowDropped = 0;
+	m_unHeadroomWindows = 0;
+	m_unHoldWindows = k_unHoldWindowsAfterChange;
+	m_flLastWindowGpuMs = 0.0f;
+	m_unLastWindowDropped = 0;
+}
+
+float CGlyphRenderScaler::Quantize(float flScale) const
+{
+	return k_flScaleStep * floorf(flScale / k_flScaleStep + 0.5f);
+}
+
+bool CGlyphRenderScaler::AddFrame(float flGpuMs, bool bDropped, float flFrameBudgetMs)
+{
+	m_flWindowGpuMs += flGpuMs;
+	if (bDropped)
+		m_unWindowDropped++;
+
+	if (++m_unWindowFrames < k_unWindowFrames)
+		return false;
+
+	bool bChanged = EndWindow(flFrameBudgetMs);
+	m_unWindowFrames = 0;
+	m_flWindowGpuMs = 0.0;
+	m_unWindowDropped = 0;
+	return bChanged;
+}
+
+bool CGlyphRenderScaler::EndWindow(float flFrameBudgetMs)
+{
+	if (m_unHoldWindows > 0) {
+		m_unHoldWindows--;
+		return false;
+	}
+	if (flFrameBudgetMs <= 0)
+		return false;
+
+	double flGpuMs = m_flWindowGpuMs / m_unWindowFrames;
+	double flLoad = flGpuMs / flFrameBudgetMs;
+	float flScale = m_flScale;
+
+	// dropped frames with an idle GPU are the CPU's doing; rendering fewer pixels would not help
+	if (flLoad > k_flOverBudget || (m_unWindowDropped > k_unMaxDroppedPerWindow && flLoad > k_flUnderBudget)) {
+		// GPU time goes with the pixel count, i.e. the square of the scale
+		double flTarget = m_flScale * sqrt(k_flTargetBudget / flLoad);
+		flScale = std::min<float>(k_flScaleStep * floorf((float)flTarget / k_flScaleStep), m_flScale - k_flScaleStep);
+		m_unHeadroomWindows = 0;
+	}
+	else if (flLoad < k_flUnderBudget && m_unWindowDropped == 0) {
+		if (++m_unHeadroomWindows >= k_unHeadroomWindowsToGrow) {
+			flScale = m_flScale + k_flScaleStep;
+			m_unHeadroomWindows = 0;
+		}
+	}
+	else {
+		m_unHeadroomWindows = 0;
+	}
+
+	flScale = std::min<float>(std::max<float>(Quantize(flScale), m_flMinScale), m_flMaxScale);
+	if (fabsf(flScale - m_flScale) < 0.5f * k_flScaleStep)
+		return false;
+
+	m_flScale = flScale;
+	m_unHoldWindows = k_unHoldWindowsAfterChange;
+	m_flLastWindowGpuMs = (float)flGpuMs;
+	m_unLastWindowDropped = m_unWindowDropped;
+	return true;
+}
@@ -0,0 +1,58 @@
+#ifndef GLYPH_RENDER_SCALE_H
+#define GLYPH_RENDER_SCALE_H
+
+#pragma once
+
+#include <stdint.h>
+
+// --------------------------------------------------------------------------
+// Purpose: Picks the render target scale from compositor frame timing.
+//          Application GPU time is averaged over windows of frames. A window
+//          over budget, or dropping frames while the GPU is busy, scales
+//          down right away; only several windows in a row with ample
+//          headroom scale back up, one step at a time. Each change is
+//          followed by a hold-off so the new size settles before it is
+//          judged, and applications that re-query the size do not see it
+//          move every frame.
+// --------------------------------------------------------------------------
+class CGlyphRenderScaler
+{
+public:
+	CGlyphRenderScaler();
+
+	void Configure(float flInitialScale, float flMinScale, float flMaxScale);
+
+	// One presented frame: its application GPU time and whether the
+	// compositor dropped or mispresented it. Returns true if the scale changed.
+	bool AddFrame(float flGpuMs, bool bDropped, float flFrameBudgetMs);
+
+	float GetScale() const { return m_flScale; }
+
+	// the window that produced the last change, for the log
+	float GetLastWindowGpuMs() const { return m_flLastWindowGpuMs; }
+	uint32_t GetLastWindowDropped() const { return m_unLastWindowDropped; }
+
+	// scale steps are this coarse so sizes repeat instead of drifting
+	static const float k_flScaleStep;
+
+private:
+	bool EndWindow(float flFrameBudgetMs);
+	float Quantize(float flScale) const;
+
+	float m_flScale;
+	float m_flMinScale;
+	float m_flMaxScale;
+
+	uint32_t m_unWindowFrames;
+	double m_flWindowGpuMs;
+	uint32_t m_unWindowDropped;
+
+	uint32_t m_unHeadroomWindows;	// consecutive windows with room to grow
+	uint32_t m_unHoldWindows;		// windows still ignored after a change
+
+	float m_flLastWindowGpuMs;
+	uint32_t m_unLastWindowDropped;
+};
+
+
+#endif // GLYPH_RENDER_SCALE_H
@@ -0,0 +1,87 @@
+#ifndef GLYPH_SAMPLE_H
+#define GLYPH_SAMPLE_H
+
+#pragma once
+
+#include <stdint.h>
+
+// axes in DIJOYSTATE2 order, so a DirectInput object offset divided by
+// sizeof(LONG) is the axis index
+enum EGlyphAxis
+{
+	GlyphAxis_X = 0,
+	GlyphAxis_Y,
+	GlyphAxis_Z,
+	GlyphAxis_RX,
+	GlyphAxis_RY,
+	GlyphAxis_RZ,
+	GlyphAxis_Slider0,
+	GlyphAxis_Slider1,
+
+	GlyphAxis_Count
+};
+
+// buttons carried in GlyphSample_t::unButtons; any beyond these are ignored
+static const uint32_t k_unGlyphMaxButtons = 32;
+
+// --------------------------------------------------------------------------
+// Purpose: One raw tracker report
+// --------------------------------------------------------------------------
+struct GlyphSample_t
+{
+	uint32_t unSequence;	// device report sequence number
+	int64_t nTimestamp;		// GlyphTicksNow() time the report was produced
+	int32_t rgnAxis[GlyphAxis_Count];
+	uint32_t unButtons;		// bit n set while button n is held
+};
+
+// --------------------------------------------------------------------------
+// Purpose: Fixed size history of the most recent samples. Single writer;
+//          nCapacity must be a power of two.
+// --------------------------------------------------------------------------
+template <uint32_t nCapacity>
+class CGlyphSampleRing
+{
+	static_assert((nCapacity & (nCapacity - 1)) == 0, "sample ring capacity must be a power of two");
+
+public:
+	CGlyphSampleRing()
+	{
+		Clear();
+	}
+
+	void Clear()
+	{
+		m_unCount = 0;
+		m_unHead = 0;
+		m_rgSamples[0] = GlyphSample_t();
+	}
+
+	void Push(const GlyphSample_t &sample)
+	{
+		m_unHead = (m_unHead + 1) & (nCapacity - 1);
+		m_rgSamples[m_unHead] = sample;
+		if (m_unCount < nCapacity)
+			m_unCount++;
+	}
+
+	static uint32_t Capacity() { return nCapacity; }
+	uint32_t Count() const { return m_unCount; }
+	bool IsEmpty() const { return m_unCount == 0; }
+
+	// unAge 0 is the newest sample, Count() - 1 the oldest
+	const GlyphSample_t &Get(uint32_t unAge) const
+	{
+		return m_rgSamples[(m_unHead - unAge) & (nCapacity - 1)];
+	}
+
+	const GlyphSample_t &Latest() const { return m_rgSamples[m_unHead]; }
+
+private:
+	GlyphSample_t m_rgSamples[nCapacity];
+	uint32_t m_unHead;
+	uint32_t m_unCount;
+};
+
+
+#endif // GLYPH_SAMPLE_H
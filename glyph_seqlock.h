@@ -0,0 +1,65 @@
+#ifndef GLYPH_SEQLOCK_H
+#define GLYPH_SEQLOCK_H
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+// --------------------------------------------------------------------------
+// Purpose: Single writer, many reader sequence lock. The writer never waits;
+//          readers retry until they copy a value no write overlapped, so a
+//          reader never sees a torn value. T must be trivially copyable.
+// --------------------------------------------------------------------------
+template <typename T>
+class CGlyphSeqLock
+{
+public:
+	CGlyphSeqLock()
+		: m_unSequence(0)
+		, m_value()
+	{
+	}
+
+	void Store(const T &value)
+	{
+		uint32_t unSequence = m_unSequence.load(std::memory_order_relaxed);
+
+		// odd sequence marks a write in progress
+		m_unSequence.store(unSequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		m_value = value;
+
+		m_unSequence.store(unSequence + 2, std::memory_order_release);
+	}
+
+	T Load() const
+	{
+		T value;
+		uint32_t unBefore, unAfter;
+		do {
+			unBefore = m_unSequence.load(std::memory_order_acquire);
+			value = m_value;
+			std::atomic_thread_fence(std::memory_order_acquire);
+			unAfter = m_unSequence.load(std::memory_order_relaxed);
+		} while ((unBefore & 1) || unBefore != unAfter);
+		return value;
+	}
+
+	// number of completed writes
+	uint32_t Version() const
+	{
+		return m_unSequence.load(std::memory_order_acquire) >> 1;
+	}
+
+private:
+	CGlyphSeqLock(const CGlyphSeqLock &);
+	CGlyphSeqLock &operator=(const CGlyphSeqLock &);
+
+	std::atomic<uint32_t> m_unSequence;
+	T m_value;
+};
+
+
+#endif // GLYPH_SEQLOCK_H
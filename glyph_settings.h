@@ -0,0 +1,124 @@
+#ifndef GLYPH_SETTINGS_H
+#define GLYPH_SETTINGS_H
+
+#pragma once
+
+#include <openvr_driver.h>
+#include <string.h>
+#include <stdio.h>
+
+// keys for the "driver_glyph" section of steamvr.vrsettings
+static const char * const k_pch_Glyph_Section = "driver_glyph";
+static const char * const k_pch_Glyph_UseSBS_Bool = "useSBS";
+static const char * const k_pch_Glyph_EventDrivenInput_Bool = "eventDrivenInput";
+static const char * const k_pch_Glyph_BufferedInput_Bool = "bufferedInput";
+static const char * const k_pch_Glyph_InputBackend_String = "inputBackend";
+static const char * const k_pch_Glyph_PredictionHorizon_Float = "predictionHorizon";
+static const char * const k_pch_Glyph_PredictionVelocityWindow_Float = "predictionVelocityWindow";
+static const char * const k_pch_Glyph_FilterMinCutoff_Float = "filterMinCutoff";
+static const char * const k_pch_Glyph_FilterBeta_Float = "filterBeta";
+static const char * const k_pch_Glyph_FilterDerivativeCutoff_Float = "filterDerivativeCutoff";
+static const char * const k_pch_Glyph_PublishMinAngle_Float = "publishMinAngle";
+static const char * const k_pch_Glyph_PublishRateMultiple_Float = "publishRateMultiple";
+static const char * const k_pch_Glyph_PublishMaxInterval_Float = "publishMaxInterval";
+static const char * const k_pch_Glyph_VsyncAlignedPublish_Bool = "vsyncAlignedPublish";
+static const char * const k_pch_Glyph_VsyncPublishLead_Float = "vsyncPublishLead";
+static const char * const k_pch_Glyph_SecondsFromVsyncToPhotons_Float = "secondsFromVsyncToPhotons";
+static const char * const k_pch_Glyph_AsyncLog_Bool = "asyncLog";
+static const char * const k_pch_Glyph_LogLevel_String = "logLevel";
+static const char * const k_pch_Glyph_RecordFile_String = "recordFile";
+static const char * const k_pch_Glyph_ReplayFile_String = "replayFile";
+static const char * const k_pch_Glyph_ReplayRealTime_Bool = "replayRealTime";
+static const char * const k_pch_Glyph_DisplayAdapter_String = "displayAdapter";
+static const char * const k_pch_Glyph_DisplayMonitor_Int32 = "displayMonitor";
+static const char * const k_pch_Glyph_DistortionK1_Float = "distortionK1";
+static const char * const k_pch_Glyph_DistortionK2_Float = "distortionK2";
+static const char * const k_pch_Glyph_DistortionK3_Float = "distortionK3";
+static const char * const k_pch_Glyph_DistortionScaleRed_Float = "distortionScaleRed";
+static const char * const k_pch_Glyph_DistortionScaleGreen_Float = "distortionScaleGreen";
+static const char * const k_pch_Glyph_DistortionScaleBlue_Float = "distortionScaleBlue";
+static const char * const k_pch_Glyph_LensCenterOffset_Float = "lensCenterOffset";
+static const char * const k_pch_Glyph_FovTanLeft_Float = "fovTanLeft";
+static const char * const k_pch_Glyph_FovTanRight_Float = "fovTanRight";
+static const char * const k_pch_Glyph_FovTanTop_Float = "fovTanTop";
+static const char * const k_pch_Glyph_FovTanBottom_Float = "fovTanBottom";
+static const char * const k_pch_Glyph_RenderTargetScale_Float = "renderTargetScale";
+static const char * const k_pch_Glyph_AdaptiveRenderTarget_Bool = "adaptiveRenderTarget";
+static const char * const k_pch_Glyph_AdaptiveRenderMinScale_Float = "adaptiveRenderMinScale";
+static const char * const k_pch_Glyph_AdaptiveRenderMaxScale_Float = "adaptiveRenderMaxScale";
+static const char * const k_pch_Glyph_TrackingThreadMmcssTask_String = "trackingThreadMmcssTask";
+static const char * const k_pch_Glyph_TrackingThreadPriority_String = "trackingThreadPriority";
+static const char * const k_pch_Glyph_TrackingThreadAffinity_Int32 = "trackingThreadAffinity";
+static const char * const k_pch_Glyph_WatchdogWakeAngle_Float = "watchdogWakeAngle";
+static const char * const k_pch_Glyph_DeviceCount_Int32 = "deviceCount";
+static const char * const k_pch_Glyph_AxisMapping_String = "axisMapping";
+static const char * const k_pch_Glyph_PitchOffset_Float = "pitchOffset";
+static const char * const k_pch_Glyph_YawOffset_Float = "yawOffset";
+static const char * const k_pch_Glyph_RollOffset_Float = "rollOffset";
+static const char * const k_pch_Glyph_TrackerInstance_String = "trackerInstance";
+static const char * const k_pch_Glyph_TrackerEnumerationMs_Float = "trackerEnumerationMs";
+static const char * const k_pch_Glyph_Telemetry_Bool = "telemetry";
+
+
+// --------------------------------------------------------------------------
+// Purpose: Read a driver_glyph setting, returning the default when the key
+//          is missing from the settings file
+// --------------------------------------------------------------------------
+inline bool GlyphSettingBool(const char *pchKey, bool bDefault)
+{
+	vr::EVRSettingsError eError = vr::VRSettingsError_None;
+	bool bValue = vr::VRSettings()->GetBool(k_pch_Glyph_Section, pchKey, &eError);
+	return eError == vr::VRSettingsError_None ? bValue : bDefault;
+}
+
+inline int32_t GlyphSettingInt32(const char *pchKey, int32_t nDefault)
+{
+	vr::EVRSettingsError eError = vr::VRSettingsError_None;
+	int32_t nValue = vr::VRSettings()->GetInt32(k_pch_Glyph_Section, pchKey, &eError);
+	return eError == vr::VRSettingsError_None ? nValue : nDefault;
+}
+
+inline float GlyphSettingFloat(const char *pchKey, float flDefault)
+{
+	vr::EVRSettingsError eError = vr::VRSettingsError_None;
+	float flValue = vr::VRSettings()->GetFloat(k_pch_Glyph_Section, pchKey, &eError);
+	return eError == vr::VRSettingsError_None ? flValue : flDefault;
+}
+
+inline void GlyphSettingString(const char *pchKey, char *pchValue, uint32_t unValueLen, const char *pchDefault)
+{
+	vr::EVRSettingsError eError = vr::VRSettingsError_None;
+	vr::VRSettings()->GetString(k_pch_Glyph_Section, pchKey, pchValue, unValueLen, &eError);
+	if (eError != vr::VRSettingsError_None || pchValue[0] == 0) {
+#if defined( _WIN32 )
+		strncpy_s(pchValue, unValueLen, pchDefault, _TRUNCATE);
+#else
+		strncpy(pchValue, pchDefault, unValueLen - 1);
+		pchValue[unValueLen - 1] = 0;
+#endif
+	}
+}
+
+// Key of a setting the driver remembers per Glyph; the first Glyph uses the
+// plain key, e.g. "displayAdapter", the second "displayAdapter_1"
+inline void GlyphIndexedSettingKey(const char *pchBase, uint32_t unIndex, char *pchKey, size_t unKeyLen)
+{
+#if defined( _WIN32 )
+	if (unIndex == 0) {
+		strcpy_s(pchKey, unKeyLen, pchBase);
+	}
+	else {
+		sprintf_s(pchKey, unKeyLen, "%s_%u", pchBase, unIndex);
+	}
+#else
+	if (unIndex == 0) {
+		snprintf(pchKey, unKeyLen, "%s", pchBase);
+	}
+	else {
+		snprintf(pchKey, unKeyLen, "%s_%u", pchBase, unIndex);
+	}
+#endif
+}
+
+
+#endif // GLYPH_SETTINGS_H
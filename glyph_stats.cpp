@@ -0,0 +1,55 @@
+#include "glyph_stats.h"
+
+#include <stdio.h>
+
+const double CGlyphHistogram::k_flMicrosecondsPerTick = 1e6 * g_flGlyphSecondsPerTick;
+
+CGlyphHistogram::CGlyphHistogram()
+{
+	Reset();
+}
+
+void CGlyphHistogram::Reset()
+{
+	for (uint32_t i = 0; i < k_unBucketCount; i++)
+		m_rgunBuckets[i].store(0, std::memory_order_relaxed);
+	m_ulCount.store(0, std::memory_order_relaxed);
+	m_ulTotalMicroseconds.store(0, std::memory_order_relaxed);
+	m_unMaxMicroseconds.store(0, std::memory_order_relaxed);
+}
+
+double CGlyphHistogram::GetMeanMicroseconds() const
+{
+	uint64_t ulCount = GetCount();
+	return ulCount ? (double)m_ulTotalMicroseconds.load(std::memory_order_relaxed) / ulCount : 0.0;
+}
+
+uint32_t CGlyphHistogram::GetPercentileMicroseconds(double flFraction) const
+{
+	// sum the buckets rather than trusting m_ulCount, which a concurrent Record() may have run ahead of
+	uint64_t ulTotal = 0;
+	for (uint32_t i = 0; i < k_unBucketCount; i++)
+		ulTotal += GetBucket(i);
+	if (ulTotal == 0)
+		return 0;
+
+	uint64_t ulTarget = (uint64_t)(flFraction * ulTotal);
+	uint64_t ulSeen = 0;
+	for (uint32_t i = 0; i < k_unBucketCount - 1; i++) {
+		ulSeen += GetBucket(i);
+		if (ulSeen > ulTarget)
+			return BucketLimitMicroseconds(i);
+	}
+	return GetMaxMicroseconds();
+}
+
+void CGlyphHistogram::Format(char *pchBuffer, size_t unBufferSize) const
+{
+#if defined( _WIN32 )
+	sprintf_s(pchBuffer, unBufferSize,
+#else
+	snprintf(pchBuffer, unBufferSize,
+#endif
+		"n=%llu mean=%.0fus p50<%uus p99<%uus max=%uus",
+		(unsigned long long)GetCount(), GetMeanMicroseconds(), GetPercentileMicroseconds(0.5), GetPercentileMicroseconds(0.99), GetMaxMicroseconds());
+}
@@ -0,0 +1,94 @@
+#ifndef GLYPH_STATS_H
+#define GLYPH_STATS_H
+
+#pragma once
+
+#include "glyph_time.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <algorithm>
+
+// --------------------------------------------------------------------------
+// Purpose: Fixed bucket histogram of durations for hot path instrumentation.
+//          Bucket 0 counts durations under 1 us and bucket i those in
+//          [2^(i-1), 2^i) us; the last bucket also takes everything longer.
+//          Recording is a few relaxed atomic adds with no allocation, so any
+//          thread may record while another reads.
+// --------------------------------------------------------------------------
+class CGlyphHistogram
+{
+public:
+	static const uint32_t k_unBucketCount = 24;
+
+	CGlyphHistogram();
+
+	void Reset();
+
+	// nTicks in GlyphTicksNow() units
+	void Record(int64_t nTicks)
+	{
+		uint32_t unMicroseconds = nTicks <= 0 ? 0 : (uint32_t)std::min<double>(nTicks * k_flMicrosecondsPerTick, 4e9);
+
+		uint32_t unBucket = 0;
+		for (uint32_t v = unMicroseconds; v && unBucket < k_unBucketCount - 1; v >>= 1)
+			unBucket++;
+
+		m_rgunBuckets[unBucket].fetch_add(1, std::memory_order_relaxed);
+		m_ulCount.fetch_add(1, std::memory_order_relaxed);
+		m_ulTotalMicroseconds.fetch_add(unMicroseconds, std::memory_order_relaxed);
+
+		uint32_t unMax = m_unMaxMicroseconds.load(std::memory_order_relaxed);
+		while (unMicroseconds > unMax && !m_unMaxMicroseconds.compare_exchange_weak(unMax, unMicroseconds, std::memory_order_relaxed)) {
+		}
+	}
+
+	uint64_t GetCount() const { return m_ulCount.load(std::memory_order_relaxed); }
+	uint32_t GetBucket(uint32_t unBucket) const { return m_rgunBuckets[unBucket].load(std::memory_order_relaxed); }
+	uint32_t GetMaxMicroseconds() const { return m_unMaxMicroseconds.load(std::memory_order_relaxed); }
+	double GetMeanMicroseconds() const;
+
+	// exclusive upper edge of a bucket in us
+	static uint32_t BucketLimitMicroseconds(uint32_t unBucket) { return 1u << unBucket; }
+
+	// upper edge of the bucket holding the given fraction of samples, in us
+	uint32_t GetPercentileMicroseconds(double flFraction) const;
+
+	// one line summary, e.g. "n=1200 mean=812us p50<1024us p99<4096us max=3120us"
+	void Format(char *pchBuffer, size_t unBufferSize) const;
+
+private:
+	static const double k_flMicrosecondsPerTick;
+
+	std::atomic<uint32_t> m_rgunBuckets[k_unBucketCount];
+	std::atomic<uint64_t> m_ulCount;
+	std::atomic<uint64_t> m_ulTotalMicroseconds;
+	std::atomic<uint32_t> m_unMaxMicroseconds;
+
+	CGlyphHistogram(const CGlyphHistogram &);
+	CGlyphHistogram &operator=(const CGlyphHistogram &);
+};
+
+// --------------------------------------------------------------------------
+// Purpose: Timing of the head tracking pipeline, from the tracker read to
+//          the TrackedDevicePoseUpdated call
+// --------------------------------------------------------------------------
+struct GlyphPipelineStats_t
+{
+	CGlyphHistogram loopPeriod;			// between tracking loop iterations
+	CGlyphHistogram readDuration;		// duration of IGlyphTrackerInput::ReadSamples
+	CGlyphHistogram sampleAge;			// age of the newest sample when GetPose() reports it
+	CGlyphHistogram publishDuration;	// GetPose() plus TrackedDevicePoseUpdated
+
+	void Reset()
+	{
+		loopPeriod.Reset();
+		readDuration.Reset();
+		sampleAge.Reset();
+		publishDuration.Reset();
+	}
+};
+
+
+#endif // GLYPH_STATS_H
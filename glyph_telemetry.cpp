@@ -0,0 +1,25 @@
+#include "glyph_telemetry.h"
+#include "glyph_time.h"
+
+#include <new>
+
+void CGlyphTelemetryPublisher::InitRegion(uint32_t unIndex, uint32_t unProcessId)
+{
+	// a region left by a run that died keeps its old contents; readers see
+	// no magic until the new header is complete
+	memset(m_pRegion->header.rgchMagic, 0, sizeof(m_pRegion->header.rgchMagic));
+	std::atomic_thread_fence(std::memory_order_release);
+
+	new (&m_pRegion->telemetry) CGlyphSeqLock<GlyphTelemetry_t>();
+
+	GlyphTelemetryHeader_t &header = m_pRegion->header;
+	header.unVersion = k_unGlyphTelemetryVersion;
+	header.unRegionSize = sizeof(GlyphTelemetryRegion_t);
+	header.unGlyphIndex = unIndex;
+	header.nTicksPerSecond = GlyphTicksPerSecond();
+	header.unProcessId = unProcessId;
+	header.unReserved = 0;
+
+	std::atomic_thread_fence(std::memory_order_release);
+	memcpy(header.rgchMagic, k_rgchGlyphTelemetryMagic, sizeof(header.rgchMagic));
+}
@@ -0,0 +1,161 @@
+#ifndef GLYPH_TELEMETRY_H
+#define GLYPH_TELEMETRY_H
+
+#pragma once
+
+#include "glyph_seqlock.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined( _WINDOWS )
+#include <windows.h>
+#endif
+
+// --------------------------------------------------------------------------
+// Telemetry region layout: a GlyphTelemetryHeader_t followed by the
+// sequence word and GlyphTelemetry_t of a CGlyphSeqLock, in one named
+// shared memory region per Glyph: "Local\GlyphTelemetry" on Windows,
+// "/GlyphTelemetry" under /dev/shm on Linux, with "_1", "_2", ... appended
+// for the second and later Glyphs. Fields are naturally aligned, so the
+// offsets below hold for any compiler on the same platform. The header is
+// written once, magic last; a reader checks the magic, version and size,
+// then loads the block like any CGlyphSeqLock. Times are GlyphTicksNow()
+// ticks, comparable with QueryPerformanceCounter or CLOCK_MONOTONIC in the
+// reading process.
+// --------------------------------------------------------------------------
+static const char k_rgchGlyphTelemetryMagic[4] = { 'G', 'L', 'Y', 'T' };
+static const uint32_t k_unGlyphTelemetryVersion = 1;
+
+// bits of GlyphTelemetry_t::unState
+enum EGlyphTelemetryState
+{
+	GlyphTelemetryState_Tracking = 1 << 0,		// the tracking thread is servicing the device
+	GlyphTelemetryState_Connected = 1 << 1,		// the tracker is attached
+	GlyphTelemetryState_EventDriven = 1 << 2,	// woken by tracker reports rather than polling
+	GlyphTelemetryState_Standby = 1 << 3,		// parked by EnterStandby or PowerOff
+	GlyphTelemetryState_Moving = 1 << 4,		// the published pose carries velocity
+	GlyphTelemetryState_Recording = 1 << 5,		// samples are going to recordFile
+};
+
+// one pipeline histogram, as the "stats" debug request reports it
+struct GlyphTelemetryTiming_t
+{
+	uint64_t ulCount;
+	uint32_t unMeanMicroseconds;
+	uint32_t unP99Microseconds;		// upper edge of the 99th percentile bucket
+	uint32_t unMaxMicroseconds;
+	uint32_t unReserved;
+};
+
+struct GlyphTelemetry_t
+{
+	int64_t nUpdateTime;			// when the tracking thread wrote this
+	int64_t nSampleTime;			// when the newest sample was produced
+	int64_t nPoseTime;				// time rgflRotation is predicted for
+	double rgflRotation[4];			// w, x, y, z
+	double rgflAngularVelocity[3];	// radians per second
+	uint32_t unSampleSequence;		// tracker sequence of the newest sample
+	uint32_t unState;				// EGlyphTelemetryState bits
+
+	uint64_t ulSamplesRead;
+	uint64_t ulSamplesDropped;		// read faster than decoded and overwritten in the history
+	uint64_t ulPosesPublished;
+	uint64_t ulUpdatesSuppressed;	// held back by the publish throttle
+	uint64_t ulRecordDropped;		// samples the recorder could not keep up with
+
+	// refreshed at most every k_flGlyphTelemetryTimingInterval seconds
+	GlyphTelemetryTiming_t loopPeriod;
+	GlyphTelemetryTiming_t readDuration;
+	GlyphTelemetryTiming_t sampleAge;
+	GlyphTelemetryTiming_t publishDuration;
+};
+
+struct GlyphTelemetryHeader_t
+{
+	char rgchMagic[4];
+	uint32_t unVersion;
+	uint32_t unRegionSize;		// sizeof(GlyphTelemetryRegion_t)
+	uint32_t unGlyphIndex;
+	int64_t nTicksPerSecond;	// unit of the GlyphTelemetry_t times
+	uint32_t unProcessId;		// vrserver's
+	uint32_t unReserved;
+};
+
+struct GlyphTelemetryRegion_t
+{
+	GlyphTelemetryHeader_t header;
+	CGlyphSeqLock<GlyphTelemetry_t> telemetry;
+};
+
+static_assert(sizeof(GlyphTelemetryHeader_t) == 32, "telemetry header layout");
+static_assert(sizeof(GlyphTelemetry_t) == 224, "telemetry block layout");
+static_assert(sizeof(GlyphTelemetryRegion_t) == 264, "telemetry region layout");
+
+// the histogram summaries are costlier than the rest of the block, so they
+// are only computed this often, in seconds
+static const double k_flGlyphTelemetryTimingInterval = 0.1;
+
+// Name of the region for Glyph unIndex
+inline void GlyphTelemetryRegionName(uint32_t unIndex, char *pchName, size_t unNameLen)
+{
+#if defined( _WIN32 )
+	if (unIndex == 0) {
+		strcpy_s(pchName, unNameLen, "Local\\GlyphTelemetry");
+	}
+	else {
+		sprintf_s(pchName, unNameLen, "Local\\GlyphTelemetry_%u", unIndex);
+	}
+#else
+	if (unIndex == 0) {
+		snprintf(pchName, unNameLen, "/GlyphTelemetry");
+	}
+	else {
+		snprintf(pchName, unNameLen, "/GlyphTelemetry_%u", unIndex);
+	}
+#endif
+}
+
+// --------------------------------------------------------------------------
+// Purpose: Owns a Glyph's telemetry region in the driver. Publish() is one
+//          seqlock store into the mapped block, with no system call, so
+//          readers polling it at any rate cost the tracking thread nothing.
+// --------------------------------------------------------------------------
+class CGlyphTelemetryPublisher
+{
+public:
+	CGlyphTelemetryPublisher();
+	~CGlyphTelemetryPublisher();
+
+	// create and map the region, replacing any left by an earlier run
+	bool Open(uint32_t unIndex);
+	void Close();
+	bool IsOpen() const { return m_pRegion != NULL; }
+
+	// tracking thread only
+	void Publish(const GlyphTelemetry_t &telemetry)
+	{
+		if (m_pRegion)
+			m_pRegion->telemetry.Store(telemetry);
+	}
+
+private:
+	// construct the block in the newly mapped region and fill in the
+	// header, magic last; the rest is in glyph_telemetry_win.cpp and _linux.cpp
+	void InitRegion(uint32_t unIndex, uint32_t unProcessId);
+
+	GlyphTelemetryRegion_t *m_pRegion;
+#if defined( _WINDOWS )
+	HANDLE m_hMapping;
+#else
+	char m_rchName[32];		// shm_open name, unlinked on Close()
+#endif
+
+	CGlyphTelemetryPublisher(const CGlyphTelemetryPublisher &);
+	CGlyphTelemetryPublisher &operator=(const CGlyphTelemetryPublisher &);
+};
+
+
+#endif // GLYPH_TELEMETRY_H
@@ -0,0 +1,62 @@
+#include "glyph_telemetry.h"
+#include "driverlog.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+CGlyphTelemetryPublisher::CGlyphTelemetryPublisher()
+	: m_pRegion(NULL)
+{
+	m_rchName[0] = 0;
+}
+
+CGlyphTelemetryPublisher::~CGlyphTelemetryPublisher()
+{
+	Close();
+}
+
+// The shm object outlives the mapping, so Close() unlinks it; readers that
+// still have it mapped keep their view of the final block
+bool CGlyphTelemetryPublisher::Open(uint32_t unIndex)
+{
+	if (m_pRegion)
+		return true;
+
+	GlyphTelemetryRegionName(unIndex, m_rchName, sizeof(m_rchName));
+	int nFd = shm_open(m_rchName, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (nFd < 0) {
+		DriverLog("Unable to create telemetry region %s: %i\n", m_rchName, errno);
+		m_rchName[0] = 0;
+		return false;
+	}
+
+	void *pMapping = MAP_FAILED;
+	if (ftruncate(nFd, sizeof(GlyphTelemetryRegion_t)) == 0)
+		pMapping = mmap(NULL, sizeof(GlyphTelemetryRegion_t), PROT_READ | PROT_WRITE, MAP_SHARED, nFd, 0);
+	close(nFd);
+	if (pMapping == MAP_FAILED) {
+		DriverLog("Unable to map telemetry region %s: %i\n", m_rchName, errno);
+		shm_unlink(m_rchName);
+		m_rchName[0] = 0;
+		return false;
+	}
+
+	m_pRegion = (GlyphTelemetryRegion_t *)pMapping;
+	InitRegion(unIndex, (uint32_t)getpid());
+	DriverLog("Publishing telemetry in /dev/shm%s\n", m_rchName);
+	return true;
+}
+
+void CGlyphTelemetryPublisher::Close()
+{
+	if (m_pRegion) {
+		munmap(m_pRegion, sizeof(GlyphTelemetryRegion_t));
+		m_pRegion = NULL;
+	}
+	if (m_rchName[0]) {
+		shm_unlink(m_rchName);
+		m_rchName[0] = 0;
+	}
+}
@@ -0,0 +1,54 @@
+#include "glyph_telemetry.h"
+#include "driverlog.h"
+
+#include <windows.h>
+
+CGlyphTelemetryPublisher::CGlyphTelemetryPublisher()
+	: m_pRegion(NULL)
+	, m_hMapping(NULL)
+{
+}
+
+CGlyphTelemetryPublisher::~CGlyphTelemetryPublisher()
+{
+	Close();
+}
+
+// Pagefile backed, so the region lives exactly as long as some process has
+// it open; a reader that keeps it open sees the next run reuse it
+bool CGlyphTelemetryPublisher::Open(uint32_t unIndex)
+{
+	if (m_pRegion)
+		return true;
+
+	char rchName[64];
+	GlyphTelemetryRegionName(unIndex, rchName, sizeof(rchName));
+	m_hMapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, sizeof(GlyphTelemetryRegion_t), rchName);
+	if (!m_hMapping) {
+		DriverLog("Unable to create telemetry region %s: %i\n", rchName, GetLastError());
+		return false;
+	}
+
+	m_pRegion = (GlyphTelemetryRegion_t *)MapViewOfFile(m_hMapping, FILE_MAP_WRITE, 0, 0, sizeof(GlyphTelemetryRegion_t));
+	if (!m_pRegion) {
+		DriverLog("Unable to map telemetry region %s: %i\n", rchName, GetLastError());
+		Close();
+		return false;
+	}
+
+	InitRegion(unIndex, GetCurrentProcessId());
+	DriverLog("Publishing telemetry in %s\n", rchName);
+	return true;
+}
+
+void CGlyphTelemetryPublisher::Close()
+{
+	if (m_pRegion) {
+		UnmapViewOfFile(m_pRegion);
+		m_pRegion = NULL;
+	}
+	if (m_hMapping) {
+		CloseHandle(m_hMapping);
+		m_hMapping = NULL;
+	}
+}
@@ -0,0 +1,55 @@
+#ifndef GLYPH_THREAD_H
+#define GLYPH_THREAD_H
+
+#pragma once
+
+#include <stdint.h>
+
+enum EGlyphThreadPriority
+{
+	GlyphThreadPriority_Normal,
+	GlyphThreadPriority_AboveNormal,
+	GlyphThreadPriority_Highest,
+	GlyphThreadPriority_TimeCritical,
+};
+
+// "normal", "above_normal", "highest" or "time_critical"
+extern const char *GlyphThreadPriorityName(EGlyphThreadPriority ePriority);
+extern bool ParseGlyphThreadPriority(const char *pchName, EGlyphThreadPriority *pePriority);
+
+// --------------------------------------------------------------------------
+// Purpose: Scheduling for a latency sensitive thread: registration with an
+//          MMCSS task class such as "Pro Audio" or "Games", a priority and
+//          a CPU affinity mask. Apply() and Revert() act on the calling
+//          thread and must be called from the same one. Under MMCSS the
+//          priority is the task's relative priority, since the scheduler
+//          service then owns the thread priority. Linux has no MMCSS; the
+//          priorities map to nice values and time_critical to SCHED_FIFO.
+// --------------------------------------------------------------------------
+class CGlyphThreadScheduling
+{
+public:
+	CGlyphThreadScheduling();
+	~CGlyphThreadScheduling();
+
+	// An empty pchMmcssTask skips MMCSS and a zero mask leaves affinity
+	// alone. Anything the system refuses is logged and skipped; the result
+	// is logged in one line.
+	void Apply(const char *pchThreadName, const char *pchMmcssTask, EGlyphThreadPriority ePriority, uint64_t ulAffinityMask);
+	void Revert();
+
+private:
+	bool m_bApplied;
+	void *m_hMmcss;
+	int m_nPreviousPriority;		// thread priority, or nice value on Linux
+	uint64_t m_ulPreviousAffinity;	// 0 if affinity was not changed
+#if !defined( _WINDOWS )
+	int m_nPreviousPolicy;			// -1 unless time_critical changed the policy
+#endif
+
+	CGlyphThreadScheduling(const CGlyphThreadScheduling &);
+	CGlyphThreadScheduling &operator=(const CGlyphThreadScheduling &);
+};
+
+
+#endif // GLYPH_THREAD_H
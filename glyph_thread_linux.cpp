@@ -0,0 +1,166 @@
+#include "glyph_thread.h"
+#include "driverlog.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <strings.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+struct GlyphThreadPriorityInfo_t
+{
+	const char *pchName;
+	int nNice;
+	bool bRealTime;
+};
+
+// indexed by EGlyphThreadPriority; raising priority needs CAP_SYS_NICE or an
+// RLIMIT_NICE / RLIMIT_RTPRIO allowance, as rtkit or limits.conf grant
+static const GlyphThreadPriorityInfo_t k_rgThreadPriorities[] =
+{
+	{ "normal", 0, false },
+	{ "above_normal", -5, false },
+	{ "highest", -10, false },
+	{ "time_critical", -10, true },
+};
+
+static const uint32_t k_unThreadPriorityCount = sizeof(k_rgThreadPriorities) / sizeof(k_rgThreadPriorities[0]);
+
+// SCHED_FIFO priority of a time_critical thread, low in the range so kernel
+// and audio threads still preempt it
+static const int k_nRealTimePriority = 10;
+
+const char *GlyphThreadPriorityName(EGlyphThreadPriority ePriority)
+{
+	return (uint32_t)ePriority < k_unThreadPriorityCount ? k_rgThreadPriorities[ePriority].pchName : "unknown";
+}
+
+bool ParseGlyphThreadPriority(const char *pchName, EGlyphThreadPriority *pePriority)
+{
+	for (uint32_t i = 0; i < k_unThreadPriorityCount; i++) {
+		if (!strcasecmp(pchName, k_rgThreadPriorities[i].pchName)) {
+			*pePriority = (EGlyphThreadPriority)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+// nice values are per thread on Linux, addressed by thread id
+static pid_t CurrentThreadId()
+{
+	return (pid_t)syscall(SYS_gettid);
+}
+
+
+CGlyphThreadScheduling::CGlyphThreadScheduling()
+	: m_bApplied(false)
+	, m_hMmcss(NULL)
+	, m_nPreviousPriority(0)
+	, m_ulPreviousAffinity(0)
+	, m_nPreviousPolicy(-1)
+{
+}
+
+CGlyphThreadScheduling::~CGlyphThreadScheduling()
+{
+	Revert();
+}
+
+void CGlyphThreadScheduling::Apply(const char *pchThreadName, const char *pchMmcssTask, EGlyphThreadPriority ePriority, uint64_t ulAffinityMask)
+{
+	Revert();
+
+	pthread_t thread = pthread_self();
+	const GlyphThreadPriorityInfo_t &priority = k_rgThreadPriorities[(uint32_t)ePriority < k_unThreadPriorityCount ? ePriority : GlyphThreadPriority_Normal];
+	m_bApplied = true;
+
+	if (pchMmcssTask && *pchMmcssTask) {
+		DriverLog("MMCSS task \"%s\" ignored for %s, MMCSS is Windows only\n", pchMmcssTask, pchThreadName);
+	}
+
+	errno = 0;
+	m_nPreviousPriority = getpriority(PRIO_PROCESS, CurrentThreadId());
+	if (errno != 0) {
+		m_nPreviousPriority = 0;
+	}
+	if (setpriority(PRIO_PROCESS, CurrentThreadId(), priority.nNice) != 0) {
+		DriverLog("Unable to set nice %d for %s: %i\n", priority.nNice, pchThreadName, errno);
+	}
+
+	int nPolicy = SCHED_OTHER;
+	struct sched_param param;
+	param.sched_priority = 0;
+	pthread_getschedparam(thread, &nPolicy, &param);
+	if (priority.bRealTime && nPolicy != SCHED_FIFO) {
+		struct sched_param realTime;
+		realTime.sched_priority = k_nRealTimePriority;
+		int nError = pthread_setschedparam(thread, SCHED_FIFO, &realTime);
+		if (nError != 0) {
+			DriverLog("Unable to make %s real time: %i\n", pchThreadName, nError);
+		}
+		else {
+			m_nPreviousPolicy = nPolicy;
+			nPolicy = SCHED_FIFO;
+		}
+	}
+
+	char rchAffinity[32] = "any";
+	if (ulAffinityMask) {
+		cpu_set_t previous;
+		CPU_ZERO(&previous);
+		pthread_getaffinity_np(thread, sizeof(previous), &previous);
+
+		cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+		for (int i = 0; i < 64; i++) {
+			if (ulAffinityMask & (1ull << i))
+				CPU_SET(i, &cpus);
+		}
+
+		int nError = pthread_setaffinity_np(thread, sizeof(cpus), &cpus);
+		if (nError != 0) {
+			DriverLog("Unable to pin %s to CPUs 0x%llx: %i\n", pchThreadName, (unsigned long long)ulAffinityMask, nError);
+		}
+		else {
+			// only the first 64 CPUs come back on Revert(), as many as a mask can name
+			for (int i = 0; i < 64; i++) {
+				if (CPU_ISSET(i, &previous))
+					m_ulPreviousAffinity |= 1ull << i;
+			}
+			snprintf(rchAffinity, sizeof(rchAffinity), "0x%llx", (unsigned long long)ulAffinityMask);
+		}
+	}
+
+	DriverLog("%s scheduling: %s, priority %s (nice %d), CPUs %s\n", pchThreadName, nPolicy == SCHED_FIFO ? "SCHED_FIFO" : "SCHED_OTHER",
+		priority.pchName, getpriority(PRIO_PROCESS, CurrentThreadId()), rchAffinity);
+}
+
+void CGlyphThreadScheduling::Revert()
+{
+	if (!m_bApplied)
+		return;
+
+	pthread_t thread = pthread_self();
+	if (m_nPreviousPolicy >= 0) {
+		struct sched_param param;
+		param.sched_priority = 0;
+		pthread_setschedparam(thread, m_nPreviousPolicy, &param);
+		m_nPreviousPolicy = -1;
+	}
+	setpriority(PRIO_PROCESS, CurrentThreadId(), m_nPreviousPriority);
+	if (m_ulPreviousAffinity) {
+		cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+		for (int i = 0; i < 64; i++) {
+			if (m_ulPreviousAffinity & (1ull << i))
+				CPU_SET(i, &cpus);
+		}
+		pthread_setaffinity_np(thread, sizeof(cpus), &cpus);
+		m_ulPreviousAffinity = 0;
+	}
+	m_bApplied = false;
+}
@@ -0,0 +1,118 @@
+#include "glyph_thread.h"
+#include "driverlog.h"
+
+#include <windows.h>
+#include <avrt.h>
+
+struct GlyphThreadPriorityInfo_t
+{
+	const char *pchName;
+	int nThreadPriority;
+	AVRT_PRIORITY eMmcssPriority;
+};
+
+// indexed by EGlyphThreadPriority
+static const GlyphThreadPriorityInfo_t k_rgThreadPriorities[] =
+{
+	{ "normal", THREAD_PRIORITY_NORMAL, AVRT_PRIORITY_NORMAL },
+	{ "above_normal", THREAD_PRIORITY_ABOVE_NORMAL, AVRT_PRIORITY_HIGH },
+	{ "highest", THREAD_PRIORITY_HIGHEST, AVRT_PRIORITY_HIGH },
+	{ "time_critical", THREAD_PRIORITY_TIME_CRITICAL, AVRT_PRIORITY_CRITICAL },
+};
+
+static const uint32_t k_unThreadPriorityCount = sizeof(k_rgThreadPriorities) / sizeof(k_rgThreadPriorities[0]);
+
+const char *GlyphThreadPriorityName(EGlyphThreadPriority ePriority)
+{
+	return (uint32_t)ePriority < k_unThreadPriorityCount ? k_rgThreadPriorities[ePriority].pchName : "unknown";
+}
+
+bool ParseGlyphThreadPriority(const char *pchName, EGlyphThreadPriority *pePriority)
+{
+	for (uint32_t i = 0; i < k_unThreadPriorityCount; i++) {
+		if (!_stricmp(pchName, k_rgThreadPriorities[i].pchName)) {
+			*pePriority = (EGlyphThreadPriority)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+
+CGlyphThreadScheduling::CGlyphThreadScheduling()
+	: m_bApplied(false)
+	, m_hMmcss(NULL)
+	, m_nPreviousPriority(THREAD_PRIORITY_NORMAL)
+	, m_ulPreviousAffinity(0)
+{
+}
+
+CGlyphThreadScheduling::~CGlyphThreadScheduling()
+{
+	Revert();
+}
+
+void CGlyphThreadScheduling::Apply(const char *pchThreadName, const char *pchMmcssTask, EGlyphThreadPriority ePriority, uint64_t ulAffinityMask)
+{
+	Revert();
+
+	HANDLE hThread = GetCurrentThread();
+	const GlyphThreadPriorityInfo_t &priority = k_rgThreadPriorities[(uint32_t)ePriority < k_unThreadPriorityCount ? ePriority : GlyphThreadPriority_Normal];
+	m_bApplied = true;
+	m_nPreviousPriority = GetThreadPriority(hThread);
+
+	char rchMmcss[64] = "none";
+	if (pchMmcssTask && *pchMmcssTask) {
+		DWORD dwTaskIndex = 0;
+		m_hMmcss = AvSetMmThreadCharacteristicsA(pchMmcssTask, &dwTaskIndex);
+		if (!m_hMmcss) {
+			DriverLog("MMCSS task \"%s\" unavailable for %s: %i\n", pchMmcssTask, pchThreadName, GetLastError());
+		}
+		else {
+			if (!AvSetMmThreadPriority(m_hMmcss, priority.eMmcssPriority)) {
+				DriverLog("Unable to set MMCSS priority of %s: %i\n", pchThreadName, GetLastError());
+			}
+			sprintf_s(rchMmcss, "\"%s\" task %u", pchMmcssTask, dwTaskIndex);
+		}
+	}
+
+	if (!m_hMmcss && !SetThreadPriority(hThread, priority.nThreadPriority)) {
+		DriverLog("Unable to set priority of %s: %i\n", pchThreadName, GetLastError());
+	}
+
+	char rchAffinity[32] = "any";
+	if (ulAffinityMask) {
+		DWORD_PTR ulProcessMask = 0, ulSystemMask = 0;
+		GetProcessAffinityMask(GetCurrentProcess(), &ulProcessMask, &ulSystemMask);
+
+		DWORD_PTR ulMask = (DWORD_PTR)ulAffinityMask & ulProcessMask;
+		DWORD_PTR ulPrevious = ulMask ? SetThreadAffinityMask(hThread, ulMask) : 0;
+		if (!ulPrevious) {
+			DriverLog("Unable to pin %s to CPUs 0x%llx (process allows 0x%llx): %i\n", pchThreadName, (unsigned long long)ulAffinityMask, (unsigned long long)ulProcessMask, GetLastError());
+		}
+		else {
+			m_ulPreviousAffinity = ulPrevious;
+			sprintf_s(rchAffinity, "0x%llx", (unsigned long long)ulMask);
+		}
+	}
+
+	DriverLog("%s scheduling: MMCSS %s, priority %s (%i), CPUs %s\n", pchThreadName, rchMmcss, priority.pchName, GetThreadPriority(hThread), rchAffinity);
+}
+
+void CGlyphThreadScheduling::Revert()
+{
+	if (!m_bApplied)
+		return;
+
+	HANDLE hThread = GetCurrentThread();
+	if (m_hMmcss) {
+		AvRevertMmThreadCharacteristics(m_hMmcss);
+		m_hMmcss = NULL;
+	}
+	SetThreadPriority(hThread, m_nPreviousPriority);
+	if (m_ulPreviousAffinity) {
+		SetThreadAffinityMask(hThread, (DWORD_PTR)m_ulPreviousAffinity);
+		m_ulPreviousAffinity = 0;
+	}
+	m_bApplied = false;
+}
@@ -0,0 +1,60 @@
+#ifndef GLYPH_TIME_H
+#define GLYPH_TIME_H
+
+#pragma once
+
+#include <stdint.h>
+
+#if defined( _WIN32 )
+#include <windows.h>
+#else
+#include <chrono>
+#endif
+
+// --------------------------------------------------------------------------
+// Purpose: Monotonic high resolution timestamps for the tracking pipeline.
+//          std::chrono clocks are not high resolution on older MSVC
+//          runtimes, so Windows goes straight to QueryPerformanceCounter.
+// --------------------------------------------------------------------------
+#if defined( _WIN32 )
+inline int64_t GlyphTicksPerSecond()
+{
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	return frequency.QuadPart;
+}
+
+inline int64_t GlyphTicksNow()
+{
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return counter.QuadPart;
+}
+#else
+inline int64_t GlyphTicksPerSecond()
+{
+	return 1000000000;
+}
+
+inline int64_t GlyphTicksNow()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+// the counter frequency is fixed at boot, so read it once per module
+static const double g_flGlyphSecondsPerTick = 1.0 / (double)GlyphTicksPerSecond();
+static const double g_flGlyphTicksPerSecond = (double)GlyphTicksPerSecond();
+
+inline double GlyphTicksToSeconds(int64_t nTicks)
+{
+	return (double)nTicks * g_flGlyphSecondsPerTick;
+}
+
+inline int64_t GlyphSecondsToTicks(double flSeconds)
+{
+	return (int64_t)(flSeconds * g_flGlyphTicksPerSecond);
+}
+
+
+#endif // GLYPH_TIME_H
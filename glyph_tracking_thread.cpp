@@ -0,0 +1,183 @@
+#include "glyph_tracking_thread.h"
+#include "glyph_thread.h"
+#include "glyph_settings.h"
+#include "driverlog.h"
+
+#include <algorithm>
+#include <chrono>
+
+// how long a pass sleeps while some client has to be polled
+static const std::chrono::microseconds k_pollInterval(250);
+
+// MMCSS, priority and affinity of the tracking thread from the settings, so
+// its cadence holds up while the game and compositor load every core
+static void ApplyTrackingThreadScheduling(CGlyphThreadScheduling *pScheduling)
+{
+	char rchTask[64];
+	GlyphSettingString(k_pch_Glyph_TrackingThreadMmcssTask_String, rchTask, sizeof(rchTask), "");
+
+	char rchPriority[32];
+	GlyphSettingString(k_pch_Glyph_TrackingThreadPriority_String, rchPriority, sizeof(rchPriority), "highest");
+	EGlyphThreadPriority ePriority;
+	if (!ParseGlyphThreadPriority(rchPriority, &ePriority)) {
+		DriverLog("Unknown %s \"%s\", using highest\n", k_pch_Glyph_TrackingThreadPriority_String, rchPriority);
+		ePriority = GlyphThreadPriority_Highest;
+	}
+
+	uint32_t unAffinity = (uint32_t)GlyphSettingInt32(k_pch_Glyph_TrackingThreadAffinity_Int32, 0);
+	pScheduling->Apply("Head tracking thread", rchTask, ePriority, unAffinity);
+}
+
+
+CGlyphTrackingThread::CGlyphTrackingThread()
+	: m_pThread(NULL)
+	, m_hStopEvent(GLYPH_NO_WAIT_HANDLE)
+	, m_hWakeEvent(GLYPH_NO_WAIT_HANDLE)
+#if !defined( _WINDOWS )
+	, m_nEpollFd(-1)
+#endif
+	, m_unClients(0)
+{
+}
+
+CGlyphTrackingThread::~CGlyphTrackingThread()
+{
+	Stop();
+}
+
+void CGlyphTrackingThread::AddClient(IGlyphTrackingClient *pClient)
+{
+	std::lock_guard<std::mutex> lifetime(m_lifetimeMutex);
+
+	if (!m_pThread) {
+		if (!OpenEvents()) {
+			Stop();
+			return;
+		}
+		m_pThread = new std::thread(&CGlyphTrackingThread::ThreadMain, this);
+	}
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (m_unClients + m_vecPending.size() >= k_unMaxClients) {
+		DriverLog("Head tracking thread is full, %u devices already\n", m_unClients);
+		return;
+	}
+	PendingChange_t change = { pClient, true };
+	m_vecPending.push_back(change);
+	SignalWake();
+	m_changed.wait(lock, [this]() { return m_vecPending.empty(); });
+}
+
+void CGlyphTrackingThread::RemoveClient(IGlyphTrackingClient *pClient)
+{
+	std::lock_guard<std::mutex> lifetime(m_lifetimeMutex);
+	if (!m_pThread)
+		return;
+
+	bool bLast;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		PendingChange_t change = { pClient, false };
+		m_vecPending.push_back(change);
+		SignalWake();
+		m_changed.wait(lock, [this]() { return m_vecPending.empty(); });
+		bLast = m_unClients == 0;
+	}
+
+	if (bLast) {
+		Stop();
+	}
+}
+
+void CGlyphTrackingThread::Wake()
+{
+	if (m_hWakeEvent != GLYPH_NO_WAIT_HANDLE) {
+		SignalWake();
+	}
+}
+
+// must not hold m_mutex, which the thread takes on its way out
+void CGlyphTrackingThread::Stop()
+{
+	if (m_pThread) {
+		SignalStop();
+		m_pThread->join();
+		delete m_pThread;
+		m_pThread = NULL;
+	}
+	CloseEvents();
+}
+
+void CGlyphTrackingThread::ApplyPendingChanges(std::vector<IGlyphTrackingClient *> *pvecClients)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_vecPending.empty())
+		return;
+
+	for (size_t i = 0; i < m_vecPending.size(); i++) {
+		const PendingChange_t &change = m_vecPending[i];
+		std::vector<IGlyphTrackingClient *>::iterator it = std::find(pvecClients->begin(), pvecClients->end(), change.pClient);
+		if (change.bAdd && it == pvecClients->end()) {
+			change.pClient->BeginTracking(&m_deviceWatcher);
+			pvecClients->push_back(change.pClient);
+		}
+		else if (!change.bAdd && it != pvecClients->end()) {
+			change.pClient->EndTracking();
+			pvecClients->erase(it);
+		}
+	}
+	m_vecPending.clear();
+	m_unClients = (uint32_t)pvecClients->size();
+	m_changed.notify_all();
+}
+
+void CGlyphTrackingThread::ThreadMain()
+{
+	CGlyphThreadScheduling scheduling;
+	ApplyTrackingThreadScheduling(&scheduling);
+
+	// without notifications a missing tracker is still retried on its backoff schedule
+	m_deviceWatcher.Start();
+	GlyphWaitHandle_t hDeviceEvent = m_deviceWatcher.GetWakeEvent();
+
+	std::vector<IGlyphTrackingClient *> vecClients;
+	std::vector<GlyphWaitHandle_t> vecHandles;
+	for (;;) {
+		ApplyPendingChanges(&vecClients);
+
+		vecHandles.clear();
+		if (hDeviceEvent != GLYPH_NO_WAIT_HANDLE) {
+			vecHandles.push_back(hDeviceEvent);
+		}
+
+		uint32_t unTimeoutMs = k_unGlyphWaitForever;
+		bool bPoll = false;
+		for (size_t i = 0; i < vecClients.size(); i++) {
+			GlyphTrackingWait_t wait = { GLYPH_NO_WAIT_HANDLE, k_unGlyphWaitForever, false };
+			vecClients[i]->ServiceTracking(&wait);
+			if (wait.hEvent != GLYPH_NO_WAIT_HANDLE) {
+				vecHandles.push_back(wait.hEvent);
+			}
+			unTimeoutMs = std::min<uint32_t>(unTimeoutMs, wait.unTimeoutMs);
+			bPoll = bPoll || wait.bPoll;
+		}
+
+		// sleep until a tracker has a new report, a client's timeout is up, a
+		// device comes or goes, a client changes or the thread is stopped
+		EWaitResult eResult = Wait(vecHandles, bPoll ? 0 : unTimeoutMs);
+		if (eResult == WaitResult_Stopped)
+			break;
+		if (bPoll && eResult == WaitResult_TimedOut) {
+			std::this_thread::sleep_for(k_pollInterval);
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (size_t i = 0; i < vecClients.size(); i++) {
+			vecClients[i]->EndTracking();
+		}
+		m_unClients = 0;
+	}
+	m_deviceWatcher.Stop();
+}
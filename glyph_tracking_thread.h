@@ -0,0 +1,125 @@
+#ifndef GLYPH_TRACKING_THREAD_H
+#define GLYPH_TRACKING_THREAD_H
+
+#pragma once
+
+#include "glyph_hotplug.h"
+#include "glyph_wait.h"
+
+#include <stdint.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// --------------------------------------------------------------------------
+// Purpose: What a client needs before the tracking thread services it again
+// --------------------------------------------------------------------------
+struct GlyphTrackingWait_t
+{
+	GlyphWaitHandle_t hEvent;	// signalled when the client has a report waiting, or GLYPH_NO_WAIT_HANDLE
+	uint32_t unTimeoutMs;		// longest the thread may sleep before the next pass
+	bool bPoll;				// no event to wait on; service the client continuously
+};
+
+// --------------------------------------------------------------------------
+// Purpose: A device serviced by the tracking thread. All three calls run on
+//          that thread; ServiceTracking() runs on every pass, whichever
+//          client's event woke it.
+// --------------------------------------------------------------------------
+class IGlyphTrackingClient
+{
+public:
+	virtual ~IGlyphTrackingClient() {}
+
+	// pWatcher outlives the client's time on the thread
+	virtual void BeginTracking(const CGlyphDeviceWatcher *pWatcher) = 0;
+
+	// read, decode and publish whatever arrived, then fill in pWait, which
+	// starts out with no event and an infinite timeout
+	virtual void ServiceTracking(GlyphTrackingWait_t *pWait) = 0;
+
+	virtual void EndTracking() = 0;
+};
+
+// --------------------------------------------------------------------------
+// Purpose: The one thread reading every Glyph tracker. It sleeps on all the
+//          clients' report events, the device watcher and its own wake
+//          event at once, with WaitForMultipleObjects on Windows and epoll
+//          on Linux, and services each client on every pass. It starts with
+//          the first client and exits when the last one is removed.
+// --------------------------------------------------------------------------
+class CGlyphTrackingThread
+{
+public:
+	CGlyphTrackingThread();
+	~CGlyphTrackingThread();
+
+	// Both return once the thread has called BeginTracking() or EndTracking()
+	// on the client, so the caller may free it right after removing it.
+	void AddClient(IGlyphTrackingClient *pClient);
+	void RemoveClient(IGlyphTrackingClient *pClient);
+
+	// service every client now, e.g. because one entered standby
+	void Wake();
+
+	// one wait handle each, next to the thread's own three; epoll has no
+	// such limit, but both platforms take the same number of Glyphs
+	static const uint32_t k_unMaxClients = 64 - 3;
+
+private:
+	struct PendingChange_t
+	{
+		IGlyphTrackingClient *pClient;
+		bool bAdd;
+	};
+
+	enum EWaitResult
+	{
+		WaitResult_Stopped,
+		WaitResult_Signalled,
+		WaitResult_TimedOut,
+	};
+
+	void ThreadMain();
+	void ApplyPendingChanges(std::vector<IGlyphTrackingClient *> *pvecClients);
+	void Stop();
+
+	// the platform's side, in glyph_tracking_thread_win.cpp and _linux.cpp
+	bool OpenEvents();
+	void CloseEvents();
+	void SignalStop();
+	void SignalWake();
+
+	// Sleep until the stop or wake event, or one of vecHandles, is signalled
+	// or unTimeoutMs runs out. Tracking thread only.
+	EWaitResult Wait(const std::vector<GlyphWaitHandle_t> &vecHandles, uint32_t unTimeoutMs);
+
+#if !defined( _WINDOWS )
+	// epoll interest in exactly vecHandles next to the thread's own events,
+	// changing only what differs from the last pass
+	void UpdateEpollSet(const std::vector<GlyphWaitHandle_t> &vecHandles);
+#endif
+
+	std::mutex m_lifetimeMutex;		// serializes AddClient() and RemoveClient()
+	std::thread *m_pThread;
+	GlyphWaitHandle_t m_hStopEvent;		// manual reset
+	GlyphWaitHandle_t m_hWakeEvent;		// auto reset
+#if !defined( _WINDOWS )
+	int m_nEpollFd;
+	std::vector<GlyphWaitHandle_t> m_vecEpollHandles;	// registered with m_nEpollFd, tracking thread only
+#endif
+	CGlyphDeviceWatcher m_deviceWatcher;
+
+	// guarded by m_mutex; the thread applies the changes and signals m_changed
+	std::mutex m_mutex;
+	std::condition_variable m_changed;
+	std::vector<PendingChange_t> m_vecPending;
+	uint32_t m_unClients;
+
+	CGlyphTrackingThread(const CGlyphTrackingThread &);
+	CGlyphTrackingThread &operator=(const CGlyphTrackingThread &);
+};
+
+
+#endif // GLYPH_TRACKING_THREAD_H
@@ -0,0 +1,114 @@
+#include "glyph_tracking_thread.h"
+#include "driverlog.h"
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include <algorithm>
+
+// events reported by one epoll_wait(); more are picked up on the next pass
+static const int k_nMaxEpollEvents = 16;
+
+static bool AddToEpoll(int nEpollFd, int nFd)
+{
+	struct epoll_event event;
+	event.events = EPOLLIN;
+	event.data.fd = nFd;
+	return epoll_ctl(nEpollFd, EPOLL_CTL_ADD, nFd, &event) == 0;
+}
+
+bool CGlyphTrackingThread::OpenEvents()
+{
+	m_hStopEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	m_hWakeEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	m_nEpollFd = epoll_create1(EPOLL_CLOEXEC);
+	if (m_hStopEvent < 0 || m_hWakeEvent < 0 || m_nEpollFd < 0 || !AddToEpoll(m_nEpollFd, m_hStopEvent) || !AddToEpoll(m_nEpollFd, m_hWakeEvent)) {
+		DriverLog("Unable to create head tracking thread events: %i\n", errno);
+		return false;
+	}
+	m_vecEpollHandles.clear();
+	return true;
+}
+
+void CGlyphTrackingThread::CloseEvents()
+{
+	if (m_nEpollFd >= 0) {
+		close(m_nEpollFd);
+		m_nEpollFd = -1;
+	}
+	if (m_hStopEvent >= 0) {
+		close(m_hStopEvent);
+		m_hStopEvent = GLYPH_NO_WAIT_HANDLE;
+	}
+	if (m_hWakeEvent >= 0) {
+		close(m_hWakeEvent);
+		m_hWakeEvent = GLYPH_NO_WAIT_HANDLE;
+	}
+	m_vecEpollHandles.clear();
+}
+
+// the stop event is never read, so it stays set like a manual reset event
+void CGlyphTrackingThread::SignalStop()
+{
+	eventfd_write(m_hStopEvent, 1);
+}
+
+void CGlyphTrackingThread::SignalWake()
+{
+	eventfd_write(m_hWakeEvent, 1);
+}
+
+// The client set rarely changes between passes, so most passes make no
+// epoll_ctl() calls at all. Closing a descriptor drops it from the epoll set;
+// clients hand back no handle for a pass before a tracker is reopened, so a
+// reused descriptor number is always registered afresh.
+void CGlyphTrackingThread::UpdateEpollSet(const std::vector<GlyphWaitHandle_t> &vecHandles)
+{
+	for (size_t i = 0; i < m_vecEpollHandles.size(); ) {
+		if (std::find(vecHandles.begin(), vecHandles.end(), m_vecEpollHandles[i]) == vecHandles.end()) {
+			// fails harmlessly for a descriptor that has already been closed
+			epoll_ctl(m_nEpollFd, EPOLL_CTL_DEL, m_vecEpollHandles[i], NULL);
+			m_vecEpollHandles.erase(m_vecEpollHandles.begin() + i);
+		}
+		else {
+			i++;
+		}
+	}
+
+	for (size_t i = 0; i < vecHandles.size(); i++) {
+		if (std::find(m_vecEpollHandles.begin(), m_vecEpollHandles.end(), vecHandles[i]) != m_vecEpollHandles.end())
+			continue;
+		if (AddToEpoll(m_nEpollFd, vecHandles[i]) || errno == EEXIST) {
+			m_vecEpollHandles.push_back(vecHandles[i]);
+		}
+	}
+}
+
+CGlyphTrackingThread::EWaitResult CGlyphTrackingThread::Wait(const std::vector<GlyphWaitHandle_t> &vecHandles, uint32_t unTimeoutMs)
+{
+	UpdateEpollSet(vecHandles);
+
+	struct epoll_event rgEvents[k_nMaxEpollEvents];
+	int nTimeoutMs = unTimeoutMs == k_unGlyphWaitForever ? -1 : (int)std::min<uint32_t>(unTimeoutMs, 0x7fffffff);
+	int nEvents = epoll_wait(m_nEpollFd, rgEvents, k_nMaxEpollEvents, nTimeoutMs);
+	if (nEvents < 0)
+		return WaitResult_Signalled;
+	if (nEvents == 0)
+		return WaitResult_TimedOut;
+
+	// The wake event and the device watcher's are auto reset on Windows;
+	// reading them here does the same. Trackers consume their own reports.
+	GlyphWaitHandle_t hDeviceEvent = m_deviceWatcher.GetWakeEvent();
+	for (int i = 0; i < nEvents; i++) {
+		int nFd = rgEvents[i].data.fd;
+		if (nFd == m_hStopEvent)
+			return WaitResult_Stopped;
+		if (nFd == m_hWakeEvent || nFd == hDeviceEvent) {
+			eventfd_t ulCount;
+			eventfd_read(nFd, &ulCount);
+		}
+	}
+	return WaitResult_Signalled;
+}
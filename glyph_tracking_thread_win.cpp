@@ -0,0 +1,55 @@
+#include "glyph_tracking_thread.h"
+#include "driverlog.h"
+
+#include <windows.h>
+
+static_assert(CGlyphTrackingThread::k_unMaxClients + 3 <= MAXIMUM_WAIT_OBJECTS, "a wait handle for every client");
+
+bool CGlyphTrackingThread::OpenEvents()
+{
+	m_hStopEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+	m_hWakeEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+	if (!m_hStopEvent || !m_hWakeEvent) {
+		DriverLog("Unable to create head tracking thread events: %i\n", GetLastError());
+		return false;
+	}
+	return true;
+}
+
+void CGlyphTrackingThread::CloseEvents()
+{
+	if (m_hStopEvent) {
+		CloseHandle(m_hStopEvent);
+		m_hStopEvent = NULL;
+	}
+	if (m_hWakeEvent) {
+		CloseHandle(m_hWakeEvent);
+		m_hWakeEvent = NULL;
+	}
+}
+
+void CGlyphTrackingThread::SignalStop()
+{
+	SetEvent(m_hStopEvent);
+}
+
+void CGlyphTrackingThread::SignalWake()
+{
+	SetEvent(m_hWakeEvent);
+}
+
+CGlyphTrackingThread::EWaitResult CGlyphTrackingThread::Wait(const std::vector<GlyphWaitHandle_t> &vecHandles, uint32_t unTimeoutMs)
+{
+	HANDLE handles[MAXIMUM_WAIT_OBJECTS];
+	DWORD nHandles = 0;
+	handles[nHandles++] = m_hStopEvent;
+	handles[nHandles++] = m_hWakeEvent;
+	for (size_t i = 0; i < vecHandles.size() && nHandles < MAXIMUM_WAIT_OBJECTS; i++) {
+		handles[nHandles++] = vecHandles[i];
+	}
+
+	DWORD dwResult = WaitForMultipleObjects(nHandles, handles, FALSE, unTimeoutMs);
+	if (dwResult == WAIT_OBJECT_0)
+		return WaitResult_Stopped;
+	return dwResult == WAIT_TIMEOUT ? WaitResult_TimedOut : WaitResult_Signalled;
+}
@@ -0,0 +1,28 @@
+#ifndef GLYPH_WAIT_H
+#define GLYPH_WAIT_H
+
+#pragma once
+
+#include <stdint.h>
+
+#if defined( _WINDOWS )
+#include <windows.h>
+#endif
+
+// --------------------------------------------------------------------------
+// Purpose: What the tracking thread sleeps on for a device: an event handle
+//          on Windows, a file descriptor that turns readable on Linux
+// --------------------------------------------------------------------------
+#if defined( _WINDOWS )
+typedef HANDLE GlyphWaitHandle_t;
+#define GLYPH_NO_WAIT_HANDLE NULL
+#else
+typedef int GlyphWaitHandle_t;
+#define GLYPH_NO_WAIT_HANDLE (-1)
+#endif
+
+// a timeout that never runs out, as INFINITE on Windows
+static const uint32_t k_unGlyphWaitForever = 0xFFFFFFFF;
+
+
+#endif // GLYPH_WAIT_H
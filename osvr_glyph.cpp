@@ -2,19 +2,43 @@
 
 #include <openvr_driver.h>
 #include "driverlog.h"
+#include "glyph_settings.h"
+#include "glyph_pose.h"
+#include "glyph_axis_map.h"
+#include "glyph_input.h"
+#include "glyph_sample.h"
+#include "glyph_seqlock.h"
+#include "glyph_stats.h"
+#include "glyph_debug.h"
+#include "glyph_record.h"
+#include "glyph_display.h"
+#include "glyph_optics.h"
+#include "glyph_render_scale.h"
+#include "glyph_hotplug.h"
+#include "glyph_tracking_thread.h"
+#include "glyph_telemetry.h"
+#include "glyph_time.h"
 
 #include <cmath>
 #include <memory>
 #include <vector>
 #include <thread>
 #include <chrono>
+#include <atomic>
 #include <regex>
 
 #if defined( _WINDOWS )
-#define DIRECTINPUT_VERSION 0x800
 #include <windows.h>
 #include <SetupAPI.h>
-#include <dinput.h>
+#else
+#include <strings.h>
+#include <limits.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#define _stricmp strcasecmp
+#define MAX_PATH PATH_MAX
 #endif
 
 using namespace vr;
@@ -30,21 +54,6 @@ using namespace std;
 #error "Unsupported Platform."
 #endif
 
-inline double deg2rad(double deg) {
-	static const double pi_on_180 = 4.0 * atan(1.0) / 180.0;
-	return deg * pi_on_180;
-}
-
-inline HmdQuaternion_t HmdQuaternion_Init(double w, double x, double y, double z)
-{
-	HmdQuaternion_t quat;
-	quat.w = w;
-	quat.x = x;
-	quat.y = y;
-	quat.z = z;
-	return quat;
-}
-
 inline void HmdMatrix_SetIdentity(HmdMatrix34_t *pMatrix)
 {
 	pMatrix->m[0][0] = 1.f;
@@ -61,28 +70,6 @@ inline void HmdMatrix_SetIdentity(HmdMatrix34_t *pMatrix)
 	pMatrix->m[2][3] = 0.f;
 }
 
-inline HmdQuaternion_t HmdQuaternion_Rotate(double xAngle, double yAngle, double zAngle)
-{
-	double x = 1.0 * sin(deg2rad(xAngle) / 2);
-	double y = 0.0 * sin(deg2rad(xAngle) / 2);
-	double z = 0.0 * sin(deg2rad(xAngle) / 2);
-	double w = cos(deg2rad(xAngle) / 2);
-
-	x += 0.0 * sin(deg2rad(yAngle) / 2);
-	y += 1.0 * sin(deg2rad(yAngle) / 2);
-	z += 0.0 * sin(deg2rad(yAngle) / 2);
-	w += cos(deg2rad(yAngle) / 2);
-
-	x += 0.0 * sin(deg2rad(zAngle) / 2);
-	y += 0.0 * sin(deg2rad(zAngle) / 2);
-	z += 1.0 * sin(deg2rad(zAngle) / 2);
-	w += cos(deg2rad(zAngle) / 2);
-
-	double mag = sqrt(w*w + x*x + y*y + z*z);
-
-	return { w / mag, x / mag, y / mag, z / mag };
-}
-
 //-----------------------------------------------------------------------------
 // Purpose:
 //-----------------------------------------------------------------------------
@@ -105,26 +92,272 @@ private:
 CWatchdogDriver_Glyph g_watchdogDriverNull;
 
 
-bool g_bExiting = false;
+#if defined( _WINDOWS )
+static const char k_rgchDefaultInputBackend[] = "dinput";
+#else
+static const char k_rgchDefaultInputBackend[] = "evdev";
+#endif
 
-void WatchdogThreadFunction()
+// Open the tracker through the configured input, falling back to DirectInput
+// if the raw HID device cannot be used, or to evdev on Linux. Each call claims
+// a Glyph no earlier tracker holds; unIndex is the Glyph's rank among those
+// the driver adds. The returned tracker may not have found a device yet;
+// Open() can be retried on it.
+static IGlyphTrackerInput *OpenGlyphTracker(uint32_t unIndex, bool bAllowReplay)
 {
-	while (!g_bExiting)
-	{
+	IGlyphTrackerInput *pTracker;
+
+	char rchBackend[32];
+	GlyphSettingString(k_pch_Glyph_InputBackend_String, rchBackend, sizeof(rchBackend), k_rgchDefaultInputBackend);
+
+	if (!_stricmp(rchBackend, "replay") && bAllowReplay) {
+		char rchReplayPath[MAX_PATH];
+		GlyphSettingString(k_pch_Glyph_ReplayFile_String, rchReplayPath, sizeof(rchReplayPath), "");
+		pTracker = CreateReplayTracker(rchReplayPath, GlyphSettingBool(k_pch_Glyph_ReplayRealTime_Bool, true));
+		if (pTracker->Open()) {
+			DriverLog("Using recorded tracker input\n");
+			return pTracker;
+		}
+		DriverLog("Unable to replay \"%s\", falling back to %s\n", rchReplayPath, k_rgchDefaultInputBackend);
+		delete pTracker;
+	}
 #if defined( _WINDOWS )
-		// on windows send the event when the Y key is pressed.
-		if ((0x01 & GetAsyncKeyState('Y')) != 0)
-		{
-			// Y key was pressed. 
-			//vr::VRWatchdogHost()->WatchdogWakeUp();
+	else if (!_stricmp(rchBackend, "hid")) {
+		pTracker = CreateHidTracker();
+		if (pTracker->Open()) {
+			DriverLog("Using HID tracker input\n");
+			return pTracker;
 		}
-		std::this_thread::sleep_for(std::chrono::microseconds(500));
+		DriverLog("Glyph HID tracker not found, falling back to DirectInput\n");
+		delete pTracker;
+	}
+#endif
+	else if (_stricmp(rchBackend, k_rgchDefaultInputBackend) && _stricmp(rchBackend, "replay")) {
+		DriverLog("Unknown %s \"%s\", using %s\n", k_pch_Glyph_InputBackend_String, rchBackend, k_rgchDefaultInputBackend);
+	}
+
+#if defined( _WINDOWS )
+	pTracker = CreateDirectInputTracker(unIndex);
 #else
-		// for the other platforms, just send one every five seconds
-		std::this_thread::sleep_for(std::chrono::seconds(5));
-		vr::VRWatchdogHost()->WatchdogWakeUp();
+	(void)unIndex;
+	pTracker = CreateEvdevTracker();
+#endif
+	pTracker->Open();
+	return pTracker;
+}
+
+bool g_bExiting = false;
+
+// Axis assignment, signs and centering from the settings; an unparseable
+// axisMapping leaves the Glyph's own axes in place
+static void LoadGlyphAxisMapping(GlyphAxisMapping_t *pMapping, bool bLog)
+{
+	GlyphDefaultAxisMapping(pMapping);
+
+	char rchAxes[64];
+	GlyphSettingString(k_pch_Glyph_AxisMapping_String, rchAxes, sizeof(rchAxes), "");
+	if (rchAxes[0] && !ParseGlyphAxisMapping(rchAxes, pMapping) && bLog) {
+		DriverLog("Invalid %s \"%s\", expected pitch, yaw and roll axes such as \"z rx -y\"\n", k_pch_Glyph_AxisMapping_String, rchAxes);
+	}
+
+	pMapping->rgflOffset[GlyphAxisRole_Pitch] = GlyphSettingFloat(k_pch_Glyph_PitchOffset_Float, pMapping->rgflOffset[GlyphAxisRole_Pitch]);
+	pMapping->rgflOffset[GlyphAxisRole_Yaw] = GlyphSettingFloat(k_pch_Glyph_YawOffset_Float, pMapping->rgflOffset[GlyphAxisRole_Yaw]);
+	pMapping->rgflOffset[GlyphAxisRole_Roll] = GlyphSettingFloat(k_pch_Glyph_RollOffset_Float, pMapping->rgflOffset[GlyphAxisRole_Roll]);
+}
+
+// set by Cleanup to end the watchdog thread
+GlyphWaitHandle_t g_hWatchdogStopEvent = GLYPH_NO_WAIT_HANDLE;
+
+// SteamVR is woken at most this often, however much the tracker moves, in seconds
+static const double k_flWatchdogWakeInterval = 5.0;
+
+// if neither the tracker nor device notifications can signal, the tracker is looked at this often
+static const uint32_t k_unWatchdogPollMs = 250;
+
+// Sleep until one of the handles is signalled or the timeout runs out;
+// false once the stop event, pHandles[0], is set. On Linux the device
+// watcher's wake event is read here, as it is auto reset on Windows.
+static bool WatchdogWait(const GlyphWaitHandle_t *pHandles, uint32_t unHandles, uint32_t unTimeoutMs, GlyphWaitHandle_t hWakeEvent)
+{
+#if defined( _WINDOWS )
+	(void)hWakeEvent;
+	return WaitForMultipleObjects(unHandles, pHandles, FALSE, unTimeoutMs) != WAIT_OBJECT_0;
+#else
+	struct pollfd rgFds[3];
+	for (uint32_t i = 0; i < unHandles; i++) {
+		rgFds[i].fd = pHandles[i];
+		rgFds[i].events = POLLIN;
+		rgFds[i].revents = 0;
+	}
+
+	int nTimeoutMs = unTimeoutMs == k_unGlyphWaitForever ? -1 : (int)unTimeoutMs;
+	if (poll(rgFds, unHandles, nTimeoutMs) <= 0)
+		return true;
+	if (rgFds[0].revents)
+		return false;
+	for (uint32_t i = 1; i < unHandles; i++) {
+		if (rgFds[i].revents && rgFds[i].fd == hWakeEvent) {
+			eventfd_t ulCount;
+			eventfd_read(hWakeEvent, &ulCount);
+		}
+	}
+	return true;
 #endif
+}
+
+// Difference between two readings of a tracker axis, which wraps once per
+// turn over 0..65535
+static int32_t GlyphAxisDelta(int32_t nFrom, int32_t nTo)
+{
+	return (int16_t)(uint16_t)(nTo - nFrom);
+}
+
+static bool GlyphTrackerMoved(const GlyphSample_t &from, const GlyphSample_t &to, const GlyphAxisMapping_t &mapping, int32_t nThreshold)
+{
+	for (int i = 0; i < GlyphAxisRole_Count; i++) {
+		int32_t nDelta = GlyphAxisDelta(from.rgnAxis[mapping.rgeAxis[i]], to.rgnAxis[mapping.rgeAxis[i]]);
+		if (nDelta > nThreshold || nDelta < -nThreshold)
+			return true;
 	}
+	return false;
+}
+
+// --------------------------------------------------------------------------
+// Purpose: Holds the tracker open while SteamVR is not running and wakes it
+//          when the Glyph is plugged in or picked up. The thread blocks on
+//          device notifications and the tracker's report event, so while
+//          nothing happens it does not run at all.
+// --------------------------------------------------------------------------
+class CGlyphWatchdog
+{
+public:
+	CGlyphWatchdog()
+		: m_pTracker(NULL)
+		, m_bStarted(false)
+		, m_bHaveRest(false)
+		, m_nLastWake(0)
+	{
+		// a full turn is 65536 counts on each axis
+		m_nWakeCounts = (int32_t)(GlyphSettingFloat(k_pch_Glyph_WatchdogWakeAngle_Float, 10.0f) * 65536.0f / 360.0f);
+		LoadGlyphAxisMapping(&m_axisMapping, false);
+	}
+
+	~CGlyphWatchdog()
+	{
+		StopTracker();
+		delete m_pTracker;
+	}
+
+	void Run()
+	{
+		bool bNotifications = m_watcher.Start();
+		GlyphWaitHandle_t hWakeEvent = m_watcher.GetWakeEvent();
+		uint32_t unSeenDeviceChanges = m_watcher.GetDeviceChangeCount();
+
+		// a Glyph already attached when the watchdog starts only wakes SteamVR once it moves
+		m_pTracker = OpenGlyphTracker(0, false);
+		if (m_pTracker->IsOpen())
+			StartTracker();
+		DriverLog("Watchdog waiting on %s input, tracker %s, %s\n", m_pTracker->GetName(), m_bStarted ? "attached" : "not attached",
+			bNotifications ? "device notifications" : "no device notifications");
+
+		for (;;) {
+			GlyphWaitHandle_t hSampleEvent = m_bStarted ? m_pTracker->GetWaitHandle() : GLYPH_NO_WAIT_HANDLE;
+			GlyphWaitHandle_t handles[3] = { g_hWatchdogStopEvent };
+			uint32_t unHandles = 1;
+			if (hWakeEvent != GLYPH_NO_WAIT_HANDLE)
+				handles[unHandles++] = hWakeEvent;
+			if (hSampleEvent != GLYPH_NO_WAIT_HANDLE)
+				handles[unHandles++] = hSampleEvent;
+
+			uint32_t unTimeoutMs = (m_bStarted ? hSampleEvent != GLYPH_NO_WAIT_HANDLE : bNotifications) ? k_unGlyphWaitForever : k_unWatchdogPollMs;
+			if (!WatchdogWait(handles, unHandles, unTimeoutMs, hWakeEvent))
+				break;
+
+			uint32_t unDeviceChanges = m_watcher.GetDeviceChangeCount();
+			bool bDevicesChanged = unDeviceChanges != unSeenDeviceChanges;
+			unSeenDeviceChanges = unDeviceChanges;
+
+			if (m_bStarted) {
+				CheckMotion();
+				if (!m_pTracker->IsConnected()) {
+					DriverLog("Watchdog: tracker unplugged\n");
+					StopTracker();
+					m_pTracker->Close();
+				}
+			}
+			else if ((bDevicesChanged || !bNotifications) && m_pTracker->Open()) {
+				StartTracker();
+				WakeUp("tracker plugged in");
+			}
+		}
+
+		m_watcher.Stop();
+	}
+
+private:
+	void StartTracker()
+	{
+		m_pTracker->Start();
+		m_samples.Clear();
+		m_bStarted = true;
+		m_bHaveRest = false;
+	}
+
+	void StopTracker()
+	{
+		if (m_bStarted) {
+			m_pTracker->Stop();
+			m_bStarted = false;
+		}
+	}
+
+	// the first report after the tracker is opened, and after every wakeup,
+	// is where it rests; turning far enough from there counts as picking it up
+	void CheckMotion()
+	{
+		if (!m_pTracker->ReadSamples(&m_samples))
+			return;
+
+		const GlyphSample_t &latest = m_samples.Latest();
+		if (!m_bHaveRest) {
+			m_rest = latest;
+			m_bHaveRest = true;
+		}
+		else if (GlyphTrackerMoved(m_rest, latest, m_axisMapping, m_nWakeCounts)) {
+			m_rest = latest;
+			WakeUp("tracker moved");
+		}
+	}
+
+	void WakeUp(const char *pchReason)
+	{
+		int64_t nNow = GlyphTicksNow();
+		if (m_nLastWake && nNow - m_nLastWake < GlyphSecondsToTicks(k_flWatchdogWakeInterval))
+			return;
+
+		m_nLastWake = nNow;
+		DriverLog("Watchdog: %s, waking SteamVR\n", pchReason);
+		vr::VRWatchdogHost()->WatchdogWakeUp();
+	}
+
+	CGlyphDeviceWatcher m_watcher;
+	IGlyphTrackerInput *m_pTracker;
+	bool m_bStarted;
+
+	CGlyphSampleHistory m_samples;
+	GlyphSample_t m_rest;
+	bool m_bHaveRest;
+	int32_t m_nWakeCounts;
+	GlyphAxisMapping_t m_axisMapping;
+
+	int64_t m_nLastWake;
+};
+
+void WatchdogThreadFunction()
+{
+	CGlyphWatchdog watchdog;
+	watchdog.Run();
 }
 
 EVRInitError CWatchdogDriver_Glyph::Init(vr::IVRDriverContext *pDriverContext)
@@ -132,16 +365,31 @@ EVRInitError CWatchdogDriver_Glyph::Init(vr::IVRDriverContext *pDriverContext)
 	VR_INIT_WATCHDOG_DRIVER_CONTEXT(pDriverContext);
 	InitDriverLog(vr::VRDriverLog());
 
-	// Watchdog mode on Windows starts a thread that listens for the 'Y' key on the keyboard to 
-	// be pressed. A real driver should wait for a system button event or something else from the 
-	// the hardware that signals that the VR system should start up.
+	// Watchdog mode starts a thread that wakes SteamVR when the Glyph tracker is
+	// plugged in or moved.
 	g_bExiting = false;
-	/*m_pWatchdogThread = new std::thread(WatchdogThreadFunction);
+#if defined( _WINDOWS )
+	g_hWatchdogStopEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+	if (!g_hWatchdogStopEvent)
+	{
+		DriverLog("Unable to create watchdog stop event: %i\n", GetLastError());
+		return VRInitError_Driver_Failed;
+	}
+#else
+	// never read, so once written it stays set like a manual reset event
+	g_hWatchdogStopEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (g_hWatchdogStopEvent < 0)
+	{
+		DriverLog("Unable to create watchdog stop event: %i\n", errno);
+		return VRInitError_Driver_Failed;
+	}
+#endif
+	m_pWatchdogThread = new std::thread(WatchdogThreadFunction);
 	if (!m_pWatchdogThread)
 	{
 		DriverLog("Unable to create watchdog thread\n");
 		return VRInitError_Driver_Failed;
-	}*/
+	}
 
 	return VRInitError_None;
 }
@@ -150,213 +398,1259 @@ EVRInitError CWatchdogDriver_Glyph::Init(vr::IVRDriverContext *pDriverContext)
 void CWatchdogDriver_Glyph::Cleanup()
 {
 	g_bExiting = true;
+#if defined( _WINDOWS )
+	if (g_hWatchdogStopEvent)
+		SetEvent(g_hWatchdogStopEvent);
+#else
+	if (g_hWatchdogStopEvent >= 0)
+		eventfd_write(g_hWatchdogStopEvent, 1);
+#endif
 	if (m_pWatchdogThread)
 	{
 		m_pWatchdogThread->join();
 		delete m_pWatchdogThread;
 		m_pWatchdogThread = nullptr;
 	}
+#if defined( _WINDOWS )
+	if (g_hWatchdogStopEvent)
+	{
+		CloseHandle(g_hWatchdogStopEvent);
+		g_hWatchdogStopEvent = NULL;
+	}
+#else
+	if (g_hWatchdogStopEvent >= 0)
+	{
+		close(g_hWatchdogStopEvent);
+		g_hWatchdogStopEvent = GLYPH_NO_WAIT_HANDLE;
+	}
+#endif
 
 	CleanupDriverLog();
 }
 
-BOOL g_deviceIsActive = FALSE;
+// reads every active Glyph tracker
+CGlyphTrackingThread g_trackingThread;
+
+// --------------------------------------------------------------------------
+// Purpose: Decoded orientation handed from the head tracking thread to
+//          GetPose() callers
+// --------------------------------------------------------------------------
+struct GlyphTrackerState_t
+{
+	uint32_t unSequence;	// sequence of the sample it was decoded from
+	int64_t nTimestamp;		// GlyphTicksNow() time of that sample
+	int64_t nPoseTimestamp;	// time qRotation is predicted for
+	HmdQuaternion_t qRotation;
+	double vecAngularVelocity[3];
+	double vecAngularAcceleration[3];
+	bool bConnected;		// false while the tracker is unplugged
+};
+
+// a sample this old no longer says anything about current head motion, so the
+// pose stops carrying velocity and SteamVR stops extrapolating it
+static const double k_flMaxPredictionAge = 0.05;
+
+// upper bound on how long the polling thread sleeps waiting for a tracker report,
+// so a lost device still gets re-acquired and the thread notices deactivation
+static const uint32_t k_unSampleEventTimeoutMs = 100;
+
+// Glyphs enumerated at most, each read by the one tracking thread
+static const uint32_t k_unMaxGlyphDevices = 8;
+
+// retry schedule for a tracker or display that is missing, in seconds
+static const double k_flReconnectInitialDelay = 0.25;
+static const double k_flReconnectMaxDelay = 8.0;
+
+// Without a calibrated value, vsync to photons is estimated as the time the
+// display takes to scan out to the middle of the panel
+static const double k_flScanoutToPanelMiddle = 0.5;
+
+// calibrated values outside this range are rejected as typos
+static const float k_flMaxSecondsFromVsyncToPhotons = 0.1f;
+
+// accepted range of the render target scale settings
+static const float k_flMinRenderTargetScale = 0.25f;
+static const float k_flMaxRenderTargetScale = 2.0f;
+
+// frame timings fetched per RunFrame(); more than arrive between two calls
+static const uint32_t k_unFrameTimingBatch = 8;
+
+// --------------------------------------------------------------------------
+// Purpose: Values that can be changed live with the "set" debug request.
+//          Loaded from the settings, applied by the head tracking thread.
+// --------------------------------------------------------------------------
+struct GlyphTuning_t
+{
+	float flPublishMinAngle;		// degrees
+	float flPublishRateMultiple;
+	float flPublishMaxInterval;
+	float flVsyncPublishLead;
+	float flPredictionHorizon;
+	float flPredictionVelocityWindow;
+	float flFilterMinCutoff;		// Hz, 0 disables the orientation filter
+	float flFilterBeta;
+	float flFilterDerivativeCutoff;
+};
+
+// --------------------------------------------------------------------------
+// Purpose: The display mode as last read, handed from the head tracking
+//          thread, which re-reads it on display changes, to vrserver
+//          callers. The window itself is fixed at startup.
+// --------------------------------------------------------------------------
+struct GlyphDisplayMode_t
+{
+	int32_t nRenderWidth;
+	int32_t nRenderHeight;
+	float flFrequency;
+};
+
+struct GlyphTuningParam_t
+{
+	const char *pchKey;				// settings key, also the name "set" takes
+	float GlyphTuning_t::*pflValue;
+	float flDefault;
+	float flMin;
+	float flMax;
+};
+
+static const GlyphTuningParam_t k_rgGlyphTuningParams[] =
+{
+	{ k_pch_Glyph_PublishMinAngle_Float, &GlyphTuning_t::flPublishMinAngle, 0.01f, 0.0f, 10.0f },
+	{ k_pch_Glyph_PublishRateMultiple_Float, &GlyphTuning_t::flPublishRateMultiple, 4.0f, 0.0f, 100.0f },
+	{ k_pch_Glyph_PublishMaxInterval_Float, &GlyphTuning_t::flPublishMaxInterval, 0.1f, 0.0f, 10.0f },
+	{ k_pch_Glyph_VsyncPublishLead_Float, &GlyphTuning_t::flVsyncPublishLead, 0.004f, 0.0f, 0.1f },
+	{ k_pch_Glyph_PredictionHorizon_Float, &GlyphTuning_t::flPredictionHorizon, 0.0f, 0.0f, 0.1f },
+	{ k_pch_Glyph_PredictionVelocityWindow_Float, &GlyphTuning_t::flPredictionVelocityWindow, 0.010f, 0.0f, 0.1f },
+	{ k_pch_Glyph_FilterMinCutoff_Float, &GlyphTuning_t::flFilterMinCutoff, 0.0f, 0.0f, 100.0f },
+	{ k_pch_Glyph_FilterBeta_Float, &GlyphTuning_t::flFilterBeta, 20.0f, 0.0f, 1000.0f },
+	{ k_pch_Glyph_FilterDerivativeCutoff_Float, &GlyphTuning_t::flFilterDerivativeCutoff, 1.0f, 0.01f, 100.0f },
+};
+
+static const uint32_t k_unGlyphTuningParamCount = sizeof(k_rgGlyphTuningParams) / sizeof(k_rgGlyphTuningParams[0]);
+
+static const GlyphTuningParam_t *FindGlyphTuningParam(const char *pchKey)
+{
+	for (uint32_t i = 0; i < k_unGlyphTuningParamCount; i++) {
+		if (!strcmp(pchKey, k_rgGlyphTuningParams[i].pchKey))
+			return &k_rgGlyphTuningParams[i];
+	}
+	return NULL;
+}
 
 //-----------------------------------------------------------------------------
 // Purpose:
 //-----------------------------------------------------------------------------
-class CGlyphDeviceDriver : public ITrackedDeviceServerDriver, public IVRDisplayComponent
+class CGlyphDeviceDriver : public ITrackedDeviceServerDriver, public IVRDisplayComponent, public IGlyphTrackingClient
 {
 private:
-	LPDIRECTINPUT8	lpdi;
-	LPDIRECTINPUTDEVICE8  lpdiJoystick;
-	DIJOYSTATE2 joyState;
-	thread *gamepadPollingThread;
-	BOOL useSBS = false;
+	// position among the Glyphs found at startup; the first is the HMD
+	uint32_t m_unIndex;
+	IGlyphTrackerInput *m_pTracker;
+	std::atomic<bool> useSBS;
+
+	// set between EnterStandby or PowerOff and LeaveStandby; the tracking
+	// thread parks the tracker on its next pass
+	std::atomic<bool> m_bStandby;
+	bool m_bParked;
+
+	// loop state of the tracking thread
+	int64_t m_nLastLoop;
+	uint32_t m_unTuningVersion;
+
+	// decoded tracker reports, newest last; only touched by the polling thread
+	CGlyphSampleHistory m_samples;
+
+	// raw samples are written here while recordFile is set
+	std::string m_sRecordPath;
+	CGlyphSampleRecorder m_recorder;
+
+	// written by the polling thread, read by GetPose() from any thread
+	CGlyphSeqLock<GlyphTrackerState_t> m_trackerState;
+
+	// conversion from axes to rotation, chosen at activation
+	GlyphAxisMapping_t m_axisMapping;
+	GlyphAxisKernel_t m_pfnAxisKernel;
+	GlyphAxisKernelConstants_t m_axisConstants;
+
+	CGlyphOrientationFilter m_filter;
+	CGlyphPosePredictor m_predictor;
+	double m_flPredictionHorizon;
+	bool m_bPublishedMotion;
+
+	CGlyphPublishThrottle m_publishThrottle;
+
+	// newest sample's orientation after the filter
+	HmdQuaternion_t m_qDecoded;
+
+	// one boolean input component per tracker button, created once the
+	// tracker's button count is known; m_unSentButtons is the state last sent
+	vr::VRInputComponentHandle_t m_rgButtonComponents[k_unGlyphMaxButtons];
+	uint32_t m_unButtonComponents;
+	uint32_t m_unSentButtons;
+
+	// hot plug; the watcher is the tracking thread's, the counts and backoffs
+	// belong to the polling thread
+	const CGlyphDeviceWatcher *m_pDeviceWatcher;
+	uint32_t m_unSeenDeviceChanges;
+	uint32_t m_unSeenDisplayChanges;
+	bool m_bTrackerConnected;
+	CGlyphBackoff m_trackerBackoff;
+	bool m_bDisplayPending;
+	CGlyphBackoff m_displayBackoff;
+
+	// vsync aligned publishing; m_nLastVsync is written by RunFrame(), 0 until known
+	bool m_bVsyncAligned;
+	double m_flVsyncPublishLead;
+	std::atomic<int64_t> m_nLastVsync;
+
+	// written by DebugRequest(), picked up by the polling thread
+	CGlyphSeqLock<GlyphTuning_t> m_tuning;
+
+	// lens model from the settings, evaluated per vertex in ComputeDistortion()
+	GlyphOptics_t m_optics;
+	bool m_bDistortion;
+
+	// render target size is the panel size times this; the scaler and frame
+	// index belong to RunFrame()
+	std::atomic<float> m_flRenderTargetScale;
+	bool m_bAdaptiveRenderTarget;
+	CGlyphRenderScaler m_renderScaler;
+	uint32_t m_unLastFrameIndex;
+
+	GlyphPipelineStats_t m_stats;
+	std::atomic<uint64_t> m_ulSamplesRead;
+	std::atomic<uint64_t> m_ulSamplesDropped;
+	std::atomic<int64_t> m_nTrackingStart;
+	std::atomic<bool> m_bEventDriven;
+
+	// shared memory copy of the state above for outside monitors; the block
+	// and the timing refresh deadline belong to the tracking thread
+	CGlyphTelemetryPublisher m_telemetryPublisher;
+	GlyphTelemetry_t m_telemetry;
+	int64_t m_nNextTelemetryTiming;
+	bool m_bTracking;
+
+	typedef void (CGlyphDeviceDriver::*DebugCommandHandler_t)(const char *pchArgs, CGlyphDebugResponse &response);
+	struct DebugCommand_t
+	{
+		const char *pchName;
+		const char *pchUsage;
+		DebugCommandHandler_t pfnHandler;
+	};
+	static const DebugCommand_t k_rgDebugCommands[];
 public:
-	CGlyphDeviceDriver()
+	// takes ownership of pTracker, which may not have found its device yet
+	CGlyphDeviceDriver(uint32_t unIndex, IGlyphTrackerInput *pTracker)
+		: m_unIndex(unIndex)
+		, m_pTracker(pTracker)
+		, m_trackerBackoff(k_flReconnectInitialDelay, k_flReconnectMaxDelay)
+		, m_displayBackoff(k_flReconnectInitialDelay, k_flReconnectMaxDelay)
 	{
-		lpdiJoystick = NULL;
-		joyState = { 0 };
+		m_bStandby = false;
+		m_bParked = false;
+		m_nLastLoop = 0;
+		m_unTuningVersion = 0;
+		m_pDeviceWatcher = NULL;
+		m_unButtonComponents = 0;
+		m_unSentButtons = 0;
+		m_bPublishedMotion = false;
+		m_qDecoded = HmdQuaternion_Init(1, 0, 0, 0);
+		m_nLastVsync = 0;
+		m_flPredictionHorizon = 0.0;
+		m_flVsyncPublishLead = 0.0;
+		m_ulSamplesRead = 0;
+		m_ulSamplesDropped = 0;
+		m_nTrackingStart = 0;
+		m_bEventDriven = false;
+		m_telemetry = GlyphTelemetry_t();
+		m_nNextTelemetryTiming = 0;
+		m_bTracking = false;
+		m_unSeenDeviceChanges = 0;
+		m_unSeenDisplayChanges = 0;
+		m_bTrackerConnected = true;
+		m_bDisplayPending = false;
+
+		GlyphTrackerState_t initialState = { 0 };
+		initialState.nTimestamp = initialState.nPoseTimestamp = GlyphTicksNow();
+		initialState.qRotation = HmdQuaternion_Init(1, 0, 0, 0);
+		initialState.bConnected = true;
+		m_trackerState.Store(initialState);
+
 		m_unObjectId = vr::k_unTrackedDeviceIndexInvalid;
 		m_ulPropertyContainer = vr::k_ulInvalidPropertyContainer;
 
 		m_flIPD = vr::VRSettings()->GetFloat(k_pch_SteamVR_Section, k_pch_SteamVR_IPD_Float);
-		useSBS = vr::VRSettings()->GetBool("driver_glyph", "useSBS");
+		useSBS = false;
+		m_bVsyncAligned = GlyphSettingBool(k_pch_Glyph_VsyncAlignedPublish_Bool, false);
+		LoadTuning();
+		GlyphDefaultOptics(&m_optics);
+		m_bDistortion = false;
+		GlyphDefaultAxisMapping(&m_axisMapping);
+		m_pfnAxisKernel = GlyphSelectAxisKernel(m_axisMapping, &m_axisConstants);
+		LoadRenderTargetScale();
+
+		// only the first Glyph is recorded, the file has room for one
+		char rchRecordPath[MAX_PATH];
+		GlyphSettingString(k_pch_Glyph_RecordFile_String, rchRecordPath, sizeof(rchRecordPath), "");
+		if (m_unIndex == 0) {
+			m_sRecordPath = rchRecordPath;
+		}
 
-		m_sSerialNumber = "Glyph001";
+		char rchSerialNumber[16];
+#if defined( _WIN32 )
+		sprintf_s(rchSerialNumber, "Glyph%03u", m_unIndex + 1);
+#else
+		snprintf(rchSerialNumber, sizeof(rchSerialNumber), "Glyph%03u", m_unIndex + 1);
+#endif
+		m_sSerialNumber = rchSerialNumber;
 		m_sModelNumber = "Avegant Glyph";
 
 		m_nWindowX = 0;
 		m_nWindowY = 0;
-		m_nWindowWidth = m_nRenderWidth = 1280;
-		m_nWindowHeight = m_nRenderHeight = 720;
+		m_nWindowWidth = 1280;
+		m_nWindowHeight = 720;
 		m_flSecondsFromVsyncToPhotons = 0.0f;
-		m_flDisplayFrequency = 60.0f;
-
-		DISPLAY_DEVICEA *device = (DISPLAY_DEVICEA *)calloc(1, sizeof(DISPLAY_DEVICEA));
-
-		device->cb = sizeof(DISPLAY_DEVICEA);
-		int deviceIndex = 0;
-		bool found = false;
-		while (EnumDisplayDevicesA(NULL, deviceIndex, device, 0) != 0) {
-			DriverLog("Device String: %s\n", device->DeviceString);
-			DriverLog("Device Name: %s\n", device->DeviceName);
-
-			char DeviceName[32];
-			int displayIndex = 0;
-
-			strcpy_s(DeviceName, 32, device->DeviceName);
-			while (EnumDisplayDevicesA(DeviceName, displayIndex, device, 0) != 0) {
-				DriverLog("Display ID: %s\n", device->DeviceID);
-				DriverLog("Display Name: %s\n\n", device->DeviceName);
-
-				if (!strncmp("MONITOR\\AVG0065", device->DeviceID, 15)) {
-					DriverLog("Display Device Found\n");
-					DEVMODEA deviceSettings = { 0 };
-					deviceSettings.dmSize = sizeof(DEVMODEA);
-
-					DriverLog("Getting Display Settings\n");
-					if (EnumDisplaySettingsExA(DeviceName, ENUM_CURRENT_SETTINGS, &deviceSettings, 0) != 0) {
-						POINTL point = deviceSettings.dmPosition;
-						POINT mPoint = { point.x, point.y };
-						HMONITOR monitor = MonitorFromPoint(mPoint, MONITOR_DEFAULTTONEAREST);
-						MONITORINFOEXA *monInfo = (MONITORINFOEXA *)calloc(1, sizeof(MONITORINFOEXA));
-						monInfo->cbSize = sizeof(MONITORINFOEXA);
-
-						GetMonitorInfoA(monitor, monInfo);
-
-						DriverLog("Monitor Rect: %ld, %ld, %ld, %ld\n", monInfo->rcMonitor.left, monInfo->rcMonitor.right, monInfo->rcMonitor.top, monInfo->rcMonitor.bottom);
-
-						DriverLog("Display BPP: %d\n", deviceSettings.dmBitsPerPel);
-						DriverLog("Display Width: %d\n", deviceSettings.dmPelsWidth);
-						DriverLog("Display Height: %d\n", deviceSettings.dmPelsHeight);
-						DriverLog("Display Position: %d, %d\n", point.x, point.y);
-						DriverLog("Display Frequency: %d\n", deviceSettings.dmDisplayFrequency);
-
-						m_flDisplayFrequency = (float)deviceSettings.dmDisplayFrequency;
-						m_nWindowX = point.x;
-						m_nWindowY = point.y;
-						m_nWindowWidth = deviceSettings.dmPelsWidth;
-						m_nWindowHeight = deviceSettings.dmPelsHeight;
-						m_nRenderWidth = deviceSettings.dmPelsWidth;
-						m_nRenderHeight = deviceSettings.dmPelsHeight;
-
-						DriverLog("Serial Number: %s\n", m_sSerialNumber.c_str());
-						DriverLog("Model Number: %s\n", m_sModelNumber.c_str());
-						DriverLog("Window: %d %d %d %d\n", m_nWindowX, m_nWindowY, m_nWindowWidth, m_nWindowHeight);
-						DriverLog("Render Target: %d %d\n", m_nRenderWidth, m_nRenderHeight);
-						DriverLog("Seconds from Vsync to Photons: %f\n", m_flSecondsFromVsyncToPhotons);
-						DriverLog("Display Frequency: %f\n", m_flDisplayFrequency);
-						DriverLog("IPD: %f\n", m_flIPD);
-					}
-					else {
-						DriverLog("Display Info Error: %i\n", GetLastError());
-					}
-					found = true;
-				}
 
-				if (found)
-					break;
+		GlyphDisplayMode_t mode;
+		mode.nRenderWidth = m_nWindowWidth;
+		mode.nRenderHeight = m_nWindowHeight;
+		mode.flFrequency = 60.0f;
+
+		GlyphDisplayInfo_t display;
+		if (GlyphFindDisplay(m_unIndex, &display)) {
+			DriverLog("Display BPP: %d\n", display.unBitsPerPixel);
+			DriverLog("Display Position: %d, %d\n", display.nX, display.nY);
+
+			m_nWindowX = display.nX;
+			m_nWindowY = display.nY;
+			m_nWindowWidth = display.unWidth;
+			m_nWindowHeight = display.unHeight;
+			mode.nRenderWidth = display.unWidth;
+			mode.nRenderHeight = display.unHeight;
+			mode.flFrequency = display.flFrequency;
+
+			DriverLog("Serial Number: %s\n", m_sSerialNumber.c_str());
+			DriverLog("Model Number: %s\n", m_sModelNumber.c_str());
+			DriverLog("Window: %d %d %d %d\n", m_nWindowX, m_nWindowY, m_nWindowWidth, m_nWindowHeight);
+			DriverLog("Render Target: %d %d\n", mode.nRenderWidth, mode.nRenderHeight);
+			DriverLog("Display Frequency: %f\n", mode.flFrequency);
+			DriverLog("IPD: %f\n", m_flIPD);
+		}
+		m_displayMode.Store(mode);
 
-				displayIndex++;
+		LoadSecondsFromVsyncToPhotons();
+		SetSideBySide(GlyphSettingBool(k_pch_Glyph_UseSBS_Bool, false));
+	}
+
+	virtual ~CGlyphDeviceDriver()
+	{
+		delete m_pTracker;
+	}
+
+	// Settings key for a value that depends on the current display mode, e.g.
+	// "secondsFromVsyncToPhotons_1280x720@60"
+	void GetDisplayModeKey(const char *pchBase, char *pchKey, size_t unKeyLen) const
+	{
+#if defined( _WIN32 )
+		sprintf_s(pchKey, unKeyLen, "%s_%dx%d@%d", pchBase, m_nWindowWidth, m_nWindowHeight, (int)(GetDisplayFrequency() + 0.5f));
+#else
+		snprintf(pchKey, unKeyLen, "%s_%dx%d@%d", pchBase, m_nWindowWidth, m_nWindowHeight, (int)(GetDisplayFrequency() + 0.5f));
+#endif
+	}
+
+	// any thread
+	float GetDisplayFrequency() const
+	{
+		return m_displayMode.Load().flFrequency;
+	}
+
+	float EstimateSecondsFromVsyncToPhotons() const
+	{
+		float flFrequency = GetDisplayFrequency();
+		return flFrequency > 0 ? (float)(k_flScanoutToPanelMiddle / flFrequency) : 0.0f;
+	}
+
+	// Vsync to photons comes from the value calibrated for the current display
+	// mode, then the mode independent setting, then the scanout estimate.
+	void LoadSecondsFromVsyncToPhotons()
+	{
+		char rchModeKey[64];
+		GetDisplayModeKey(k_pch_Glyph_SecondsFromVsyncToPhotons_Float, rchModeKey, sizeof(rchModeKey));
+
+		const char *pchSource = rchModeKey;
+		vr::EVRSettingsError eError = vr::VRSettingsError_None;
+		float flSeconds = vr::VRSettings()->GetFloat(k_pch_Glyph_Section, rchModeKey, &eError);
+		if (eError != vr::VRSettingsError_None) {
+			pchSource = k_pch_Glyph_SecondsFromVsyncToPhotons_Float;
+			flSeconds = GlyphSettingFloat(k_pch_Glyph_SecondsFromVsyncToPhotons_Float, -1.0f);
+		}
+		if (flSeconds < 0) {
+			pchSource = "display mode estimate";
+			flSeconds = EstimateSecondsFromVsyncToPhotons();
+		}
+
+		m_flSecondsFromVsyncToPhotons = flSeconds;
+		DriverLog("Seconds from vsync to photons: %f (%s)\n", flSeconds, pchSource);
+	}
+
+	// Calibration: "vsync_to_photons" reports the current value,
+	// "vsync_to_photons <seconds>" applies a measured or hand tuned value and
+	// "vsync_to_photons estimate" goes back to the scanout estimate. A new
+	// value takes effect immediately and is stored for the current display mode.
+	// To tune by hand, turn the head steadily and adjust until the world stops
+	// lagging behind or running ahead of the motion.
+	void CalibrateVsyncToPhotons(const char *pchArgs, CGlyphDebugResponse &response)
+	{
+		char rchModeKey[64];
+		GetDisplayModeKey(k_pch_Glyph_SecondsFromVsyncToPhotons_Float, rchModeKey, sizeof(rchModeKey));
+
+		if (*pchArgs) {
+			char *pchEnd = NULL;
+			float flSeconds = !strcmp(pchArgs, "estimate") ? EstimateSecondsFromVsyncToPhotons() : (float)strtod(pchArgs, &pchEnd);
+			if ((pchEnd && (pchEnd == pchArgs || *pchEnd)) || flSeconds < 0 || flSeconds > k_flMaxSecondsFromVsyncToPhotons) {
+				response.Printf("invalid value \"%s\", expected seconds between 0 and %f or \"estimate\"\n", pchArgs, k_flMaxSecondsFromVsyncToPhotons);
+				return;
 			}
 
-			if (found)
-				break;
+			m_flSecondsFromVsyncToPhotons = flSeconds;
+			if (m_ulPropertyContainer != vr::k_ulInvalidPropertyContainer) {
+				vr::VRProperties()->SetFloatProperty(m_ulPropertyContainer, Prop_SecondsFromVsyncToPhotons_Float, flSeconds);
+			}
+			vr::VRSettings()->SetFloat(k_pch_Glyph_Section, rchModeKey, flSeconds);
+			vr::VRSettings()->Sync();
+			DriverLog("Seconds from vsync to photons calibrated to %f for %s\n", flSeconds, rchModeKey);
+		}
 
-			deviceIndex++;
+		response.Printf("%s %f\n", rchModeKey, m_flSecondsFromVsyncToPhotons.load());
+	}
+
+	void LoadOptics()
+	{
+		GlyphDefaultOptics(&m_optics);
+		m_optics.rgflRadial[0] = GlyphSettingFloat(k_pch_Glyph_DistortionK1_Float, m_optics.rgflRadial[0]);
+		m_optics.rgflRadial[1] = GlyphSettingFloat(k_pch_Glyph_DistortionK2_Float, m_optics.rgflRadial[1]);
+		m_optics.rgflRadial[2] = GlyphSettingFloat(k_pch_Glyph_DistortionK3_Float, m_optics.rgflRadial[2]);
+		m_optics.rgflChannelScale[0] = GlyphSettingFloat(k_pch_Glyph_DistortionScaleRed_Float, m_optics.rgflChannelScale[0]);
+		m_optics.rgflChannelScale[1] = GlyphSettingFloat(k_pch_Glyph_DistortionScaleGreen_Float, m_optics.rgflChannelScale[1]);
+		m_optics.rgflChannelScale[2] = GlyphSettingFloat(k_pch_Glyph_DistortionScaleBlue_Float, m_optics.rgflChannelScale[2]);
+		m_optics.flLensCenterOffset = GlyphSettingFloat(k_pch_Glyph_LensCenterOffset_Float, m_optics.flLensCenterOffset);
+		m_optics.flTanLeft = GlyphSettingFloat(k_pch_Glyph_FovTanLeft_Float, m_optics.flTanLeft);
+		m_optics.flTanRight = GlyphSettingFloat(k_pch_Glyph_FovTanRight_Float, m_optics.flTanRight);
+		m_optics.flTanTop = GlyphSettingFloat(k_pch_Glyph_FovTanTop_Float, m_optics.flTanTop);
+		m_optics.flTanBottom = GlyphSettingFloat(k_pch_Glyph_FovTanBottom_Float, m_optics.flTanBottom);
+
+		m_bDistortion = !GlyphOpticsIsIdentity(m_optics);
+		if (!m_bDistortion) {
+			DriverLog("Distortion: none\n");
 		}
+		else {
+			DriverLog("Distortion: k %f %f %f, channel scale %f %f %f, lens offset %f\n",
+				m_optics.rgflRadial[0], m_optics.rgflRadial[1], m_optics.rgflRadial[2],
+				m_optics.rgflChannelScale[0], m_optics.rgflChannelScale[1], m_optics.rgflChannelScale[2], m_optics.flLensCenterOffset);
+		}
+		DriverLog("Projection: %f %f %f %f\n", m_optics.flTanLeft, m_optics.flTanRight, m_optics.flTanTop, m_optics.flTanBottom);
+	}
 
-		DirectInput8Create(GetModuleHandle(NULL), DIRECTINPUT_VERSION, IID_IDirectInput8, (LPVOID *)&lpdi, NULL);
+	// Eyes side by side across the panel: 2 in SBS mode, otherwise 1 and both
+	// eyes share the whole panel. The Glyph stretches each half of an SBS
+	// frame over the full panel, so an eye's projection is the same in both
+	// modes and only its horizontal pixel count halves; the render target
+	// halves with it rather than rendering columns that are never shown.
+	uint32_t GetEyeColumns() const
+	{
+		return useSBS.load(std::memory_order_relaxed) ? 2 : 1;
+	}
+
+	void SetSideBySide(bool bSideBySide)
+	{
+		useSBS = bSideBySide;
 
-		lpdi->EnumDevices(DI8DEVCLASS_GAMECTRL, staticGamepadSelect, this, DIEDFL_ATTACHEDONLY);
+		uint32_t unWidth, unHeight;
+		GetRecommendedRenderTargetSize(&unWidth, &unHeight);
+		DriverLog("Side by side %s, per eye viewport %dx%d, render target %ux%u\n", bSideBySide ? "on" : "off",
+			m_nWindowWidth / (int32_t)GetEyeColumns(), m_nWindowHeight, unWidth, unHeight);
 	}
 
-	virtual ~CGlyphDeviceDriver()
+	static float ClampRenderTargetScale(float flScale)
+	{
+		return std::min<float>(std::max<float>(flScale, k_flMinRenderTargetScale), k_flMaxRenderTargetScale);
+	}
+
+	// renderTargetScale is the fixed scale, or where the adaptive scale starts
+	void LoadRenderTargetScale()
 	{
+		float flScale = ClampRenderTargetScale(GlyphSettingFloat(k_pch_Glyph_RenderTargetScale_Float, 1.0f));
+		m_bAdaptiveRenderTarget = GlyphSettingBool(k_pch_Glyph_AdaptiveRenderTarget_Bool, false);
+		m_unLastFrameIndex = 0;
+
+		if (m_bAdaptiveRenderTarget) {
+			float flMinScale = ClampRenderTargetScale(GlyphSettingFloat(k_pch_Glyph_AdaptiveRenderMinScale_Float, 0.5f));
+			float flMaxScale = ClampRenderTargetScale(GlyphSettingFloat(k_pch_Glyph_AdaptiveRenderMaxScale_Float, 1.5f));
+			m_renderScaler.Configure(flScale, flMinScale, flMaxScale);
+			flScale = m_renderScaler.GetScale();
+			DriverLog("Render target scale: adaptive from %.2f, %.2f to %.2f\n", flScale, flMinScale, flMaxScale);
+		}
+		else {
+			DriverLog("Render target scale: %.2f\n", flScale);
+		}
+		m_flRenderTargetScale = flScale;
 	}
 
-	static BOOL CALLBACK staticGamepadSelect(LPCDIDEVICEINSTANCE lpddi, LPVOID pvRef)
+	// Feed the frames presented since the last call to the adaptive scaler.
+	// A new scale is what GetRecommendedRenderTargetSize() reports next; the
+	// application picks it up whenever it asks again.
+	void UpdateRenderTargetScale()
 	{
-		CGlyphDeviceDriver * thisClass = (CGlyphDeviceDriver *)pvRef;
+		// fewer than the batch are filled in until that many frames have been shown
+		Compositor_FrameTiming rgTimings[k_unFrameTimingBatch];
+		memset(rgTimings, 0, sizeof(rgTimings));
+		rgTimings[0].m_nSize = sizeof(Compositor_FrameTiming);
+		uint32_t unTimings = std::min<uint32_t>(vr::VRServerDriverHost()->GetFrameTimings(rgTimings, k_unFrameTimingBatch), k_unFrameTimingBatch);
+		if (unTimings == 0)
+			return;
+
+		const float flFrequency = GetDisplayFrequency();
+		const float flBudgetMs = flFrequency > 0 ? 1000.0f / flFrequency : 0.0f;
+		uint32_t unNewestFrame = m_unLastFrameIndex;
+		for (uint32_t i = 0; i < unTimings; i++) {
+			const Compositor_FrameTiming &timing = rgTimings[i];
+			if (timing.m_nFrameIndex <= m_unLastFrameIndex)
+				continue;
+			unNewestFrame = std::max<uint32_t>(unNewestFrame, timing.m_nFrameIndex);
+
+			float flGpuMs = timing.m_flPreSubmitGpuMs + timing.m_flPostSubmitGpuMs;
+			bool bDropped = timing.m_nNumDroppedFrames > 0 || timing.m_nNumMisPresented > 0;
+			if (m_renderScaler.AddFrame(flGpuMs, bDropped, flBudgetMs)) {
+				DriverLog("Render target scale %.2f -> %.2f (GPU %.1f ms of %.1f ms, %u dropped)\n", m_flRenderTargetScale.load(),
+					m_renderScaler.GetScale(), m_renderScaler.GetLastWindowGpuMs(), flBudgetMs, m_renderScaler.GetLastWindowDropped());
+				m_flRenderTargetScale = m_renderScaler.GetScale();
+			}
+		}
+		m_unLastFrameIndex = unNewestFrame;
+	}
 
-		return thisClass->GamepadSelect(lpddi);
+	void LoadTuning()
+	{
+		GlyphTuning_t tuning;
+		for (uint32_t i = 0; i < k_unGlyphTuningParamCount; i++) {
+			const GlyphTuningParam_t &param = k_rgGlyphTuningParams[i];
+			tuning.*param.pflValue = GlyphSettingFloat(param.pchKey, param.flDefault);
+		}
+		m_tuning.Store(tuning);
 	}
 
-	BOOL CALLBACK GamepadSelect(LPCDIDEVICEINSTANCE lpddi)
+	// "help": list the debug commands
+	void DebugHelp(const char *pchArgs, CGlyphDebugResponse &response)
 	{
-		char ProductName[260];
-		wchar_t wProductGUID[64];
-		char ProductGUID[64];
-		 
-		StringFromGUID2(lpddi->guidProduct, wProductGUID, 64);
-		wcstombs_s(NULL, ProductGUID, wProductGUID, 64);
-		wcstombs_s(NULL, ProductName, lpddi->tszProductName, 260);
+		for (const DebugCommand_t *pCommand = k_rgDebugCommands; pCommand->pchName; pCommand++)
+			response.Printf("%s\n", pCommand->pchUsage);
+	}
 
-		if (!strcmp(ProductGUID, "{00092C43-0000-0000-0000-504944564944}")) {
-			lpdi->CreateDevice(lpddi->guidInstance, &lpdiJoystick, NULL);
-			lpdiJoystick->SetDataFormat(&c_dfDIJoystick2);
+	// "stats [reset]": publish counters and pipeline histograms. The counters
+	// belong to the polling thread and may be a moment stale.
+	void DebugStats(const char *pchArgs, CGlyphDebugResponse &response)
+	{
+		if (!strcmp(pchArgs, "reset")) {
+			m_stats.Reset();
+			response.Printf("histograms reset\n");
+			return;
+		}
 
-			DriverLog("Glyph gamepad found: %s %s\n", ProductName, ProductGUID);
+		int64_t nStart = m_nTrackingStart.load(std::memory_order_relaxed);
+		double flRunning = nStart ? GlyphTicksToSeconds(GlyphTicksNow() - nStart) : 0.0;
+		uint64_t ulSamples = m_ulSamplesRead.load(std::memory_order_relaxed);
+		uint64_t ulPublished = m_publishThrottle.GetPublishedCount();
+
+		response.Printf("running %.1f s\n", flRunning);
+		response.Printf("samples %llu (%.1f Hz), dropped %llu\n", ulSamples, flRunning > 0 ? ulSamples / flRunning : 0.0, m_ulSamplesDropped.load(std::memory_order_relaxed));
+		response.Printf("published %llu (%.1f Hz), suppressed %llu\n", ulPublished, flRunning > 0 ? ulPublished / flRunning : 0.0, m_publishThrottle.GetSuppressedCount());
+
+		char rchSummary[128];
+		m_stats.loopPeriod.Format(rchSummary, sizeof(rchSummary));
+		response.Printf("loopPeriod %s\n", rchSummary);
+		m_stats.readDuration.Format(rchSummary, sizeof(rchSummary));
+		response.Printf("readDuration %s\n", rchSummary);
+		m_stats.sampleAge.Format(rchSummary, sizeof(rchSummary));
+		response.Printf("sampleAge %s\n", rchSummary);
+		m_stats.publishDuration.Format(rchSummary, sizeof(rchSummary));
+		response.Printf("publishDuration %s\n", rchSummary);
+	}
 
-			return DIENUM_STOP;
+	// "backend": where poses come from and how often they go out
+	void DebugBackend(const char *pchArgs, CGlyphDebugResponse &response)
+	{
+		GlyphTuning_t tuning = m_tuning.Load();
+
+		response.Printf("input %s (%s, %s%s)\n", m_pTracker->GetName(), m_pTracker->IsConnected() ? "connected" : "not connected", m_bEventDriven ? "event driven" : "polling", m_bStandby ? ", standby" : "");
+		char rchAxes[32];
+		FormatGlyphAxisMapping(m_axisMapping, rchAxes, sizeof(rchAxes));
+		response.Printf("axes %s, offsets %g %g %g\n", rchAxes,
+			m_axisMapping.rgflOffset[GlyphAxisRole_Pitch], m_axisMapping.rgflOffset[GlyphAxisRole_Yaw], m_axisMapping.rgflOffset[GlyphAxisRole_Roll]);
+		const float flFrequency = GetDisplayFrequency();
+		response.Printf("display %.2f Hz\n", flFrequency);
+		uint32_t unWidth, unHeight;
+		GetRecommendedRenderTargetSize(&unWidth, &unHeight);
+		response.Printf("render target %ux%u (scale %.2f%s)\n", unWidth, unHeight, m_flRenderTargetScale.load(), m_bAdaptiveRenderTarget ? ", adaptive" : "");
+		if (m_bVsyncAligned) {
+			response.Printf("publish once per frame, %f s before vsync%s\n", tuning.flVsyncPublishLead, m_nLastVsync.load(std::memory_order_relaxed) ? "" : " (no vsync seen yet)");
+		}
+		else if (tuning.flPublishRateMultiple > 0) {
+			response.Printf("publish up to %.0f Hz\n", tuning.flPublishRateMultiple * flFrequency);
 		}
 		else {
-			DriverLog("Non Glyph Gamepad found: %s %s\n", ProductName, ProductGUID);
-			return DIENUM_CONTINUE;
+			response.Printf("publish uncapped\n");
 		}
 	}
 
-	static void staticPollGamepad(CGlyphDeviceDriver *current)
+	// "get": every live tunable value
+	void DebugGet(const char *pchArgs, CGlyphDebugResponse &response)
 	{
-		current->pollGamepad();
+		GlyphTuning_t tuning = m_tuning.Load();
+		for (uint32_t i = 0; i < k_unGlyphTuningParamCount; i++) {
+			const GlyphTuningParam_t &param = k_rgGlyphTuningParams[i];
+			response.Printf("%s %g\n", param.pchKey, tuning.*param.pflValue);
+		}
+		response.Printf("%s %s\n", k_pch_Glyph_LogLevel_String, DriverLogLevelName(GetDriverLogLevel()));
+		response.Printf("%s %d\n", k_pch_Glyph_UseSBS_Bool, useSBS ? 1 : 0);
 	}
 
-	void pollGamepad()
+	// "set <key> <value>": change a tunable value until vrserver restarts
+	void DebugSet(const char *pchArgs, CGlyphDebugResponse &response)
 	{
-		while (g_deviceIsActive) {
-			if (m_unObjectId != vr::k_unTrackedDeviceIndexInvalid)
-			{
-				HRESULT hr;
+		char rchKey[64];
+		const char *pchValue = GlyphNextDebugWord(pchArgs, rchKey, sizeof(rchKey));
+
+		if (!strcmp(rchKey, k_pch_Glyph_UseSBS_Bool)) {
+			if (strcmp(pchValue, "0") && strcmp(pchValue, "1")) {
+				response.Printf("invalid %s \"%s\", expected 0 or 1\n", rchKey, pchValue);
+				return;
+			}
+			SetSideBySide(pchValue[0] == '1');
+			response.Printf("%s %d\n", rchKey, useSBS ? 1 : 0);
+			return;
+		}
+
+		if (!strcmp(rchKey, k_pch_Glyph_LogLevel_String)) {
+			EDriverLogLevel eLevel;
+			if (!ParseDriverLogLevel(pchValue, &eLevel)) {
+				response.Printf("invalid %s \"%s\", expected debug, info, warning or error\n", rchKey, pchValue);
+				return;
+			}
+			SetDriverLogLevel(eLevel);
+			response.Printf("%s %s\n", rchKey, DriverLogLevelName(eLevel));
+			return;
+		}
 
-				if (lpdiJoystick != NULL) {
-					hr = lpdiJoystick->Poll();
+		const GlyphTuningParam_t *pParam = FindGlyphTuningParam(rchKey);
+		if (!pParam) {
+			response.Printf("unknown key \"%s\", see \"get\"\n", rchKey);
+			return;
+		}
 
-					if (FAILED(hr)) {
-						lpdiJoystick->Acquire();
-					}
-					else {
-						lpdiJoystick->GetDeviceState(sizeof(DIJOYSTATE2), &joyState);
+		char *pchEnd = NULL;
+		float flValue = (float)strtod(pchValue, &pchEnd);
+		if (pchEnd == pchValue || *pchEnd || flValue < pParam->flMin || flValue > pParam->flMax) {
+			response.Printf("invalid %s \"%s\", expected %g to %g\n", rchKey, pchValue, pParam->flMin, pParam->flMax);
+			return;
+		}
 
-						vr::VRServerDriverHost()->TrackedDevicePoseUpdated(m_unObjectId, GetPose(), sizeof(DriverPose_t));
-					}
-				}
-				std::this_thread::sleep_for(std::chrono::microseconds(250));
+		GlyphTuning_t tuning = m_tuning.Load();
+		tuning.*pParam->pflValue = flValue;
+		m_tuning.Store(tuning);
+		DriverLog("Debug request set %s to %g\n", rchKey, flValue);
+		response.Printf("%s %g\n", rchKey, flValue);
+	}
+
+	// "save": write the live values to the settings so they survive a restart
+	void DebugSave(const char *pchArgs, CGlyphDebugResponse &response)
+	{
+		GlyphTuning_t tuning = m_tuning.Load();
+		for (uint32_t i = 0; i < k_unGlyphTuningParamCount; i++) {
+			const GlyphTuningParam_t &param = k_rgGlyphTuningParams[i];
+			vr::VRSettings()->SetFloat(k_pch_Glyph_Section, param.pchKey, tuning.*param.pflValue);
+		}
+		vr::VRSettings()->SetString(k_pch_Glyph_Section, k_pch_Glyph_LogLevel_String, DriverLogLevelName(GetDriverLogLevel()));
+		vr::VRSettings()->SetBool(k_pch_Glyph_Section, k_pch_Glyph_UseSBS_Bool, useSBS);
+		vr::VRSettings()->Sync();
+		response.Printf("saved\n");
+	}
+
+	// picks the conversion kernel for the configured axes, so decoding
+	// does not look at the mapping again
+	void LoadAxisMapping()
+	{
+		LoadGlyphAxisMapping(&m_axisMapping, true);
+		m_pfnAxisKernel = GlyphSelectAxisKernel(m_axisMapping, &m_axisConstants);
+
+		char rchAxes[32];
+		FormatGlyphAxisMapping(m_axisMapping, rchAxes, sizeof(rchAxes));
+		DriverLog("Axes: pitch yaw roll %s, offsets %g %g %g\n", rchAxes,
+			m_axisMapping.rgflOffset[GlyphAxisRole_Pitch], m_axisMapping.rgflOffset[GlyphAxisRole_Yaw], m_axisMapping.rgflOffset[GlyphAxisRole_Roll]);
+	}
+
+	// Run the samples read since the last call through the orientation filter
+	// and into the predictor, then make the newest orientation, predicted
+	// m_flPredictionHorizon ahead, visible to GetPose(). Polling thread only.
+	void DecodeSamples(uint32_t unNewSamples)
+	{
+		if (unNewSamples > m_samples.Count()) {
+			m_ulSamplesDropped.fetch_add(unNewSamples - m_samples.Count(), std::memory_order_relaxed);
+			unNewSamples = m_samples.Count();
+		}
+		for (uint32_t unAge = unNewSamples; unAge-- > 0; ) {
+			const GlyphSample_t &sample = m_samples.Get(unAge);
+			m_qDecoded = m_filter.Filter(m_pfnAxisKernel(sample, m_axisConstants), sample.nTimestamp);
+			m_predictor.AddSample(m_qDecoded, sample.nTimestamp);
+		}
+
+		const GlyphSample_t &sample = m_samples.Latest();
+		GlyphTrackerState_t state;
+		state.unSequence = sample.unSequence;
+		state.nTimestamp = sample.nTimestamp;
+		state.nPoseTimestamp = sample.nTimestamp + GlyphSecondsToTicks(m_flPredictionHorizon);
+		state.qRotation = m_predictor.Extrapolate(m_qDecoded, m_flPredictionHorizon);
+		for (int i = 0; i < 3; i++) {
+			state.vecAngularVelocity[i] = m_predictor.GetAngularVelocity()[i];
+			state.vecAngularAcceleration[i] = m_predictor.GetAngularAcceleration()[i];
+		}
+		state.bConnected = true;
+
+		m_bPublishedMotion = m_predictor.IsMoving();
+		m_trackerState.Store(state);
+	}
+
+	// The tracker only reports changes, so once the head stops nothing arrives to
+	// cancel the last velocity. Republish the last sample without motion before
+	// SteamVR extrapolates it too far.
+	bool SettleStaleMotion(int64_t nNow)
+	{
+		if (!m_bPublishedMotion || m_samples.IsEmpty())
+			return false;
+
+		const GlyphSample_t &sample = m_samples.Latest();
+		if (GlyphTicksToSeconds(nNow - sample.nTimestamp) < k_flMaxPredictionAge)
+			return false;
+
+		GlyphTrackerState_t state = { 0 };
+		state.unSequence = sample.unSequence;
+		state.nTimestamp = sample.nTimestamp;
+		state.nPoseTimestamp = sample.nTimestamp;
+		state.qRotation = m_qDecoded;
+		state.bConnected = true;
+
+		m_predictor.Reset();
+		m_bPublishedMotion = false;
+		m_trackerState.Store(state);
+		return true;
+	}
+
+	// Take up new tuning values on the polling thread. Publish limits: poses go
+	// out when they turn by publishMinAngle degrees, at least every
+	// publishMaxInterval seconds, and at most publishRateMultiple times per
+	// display frame. In vsync aligned mode the frame slots replace the rate cap.
+	void ApplyTuning(const GlyphTuning_t &tuning)
+	{
+		m_flPredictionHorizon = tuning.flPredictionHorizon;
+		m_predictor.SetVelocityWindow(tuning.flPredictionVelocityWindow);
+		m_flVsyncPublishLead = tuning.flVsyncPublishLead;
+		m_filter.Configure(tuning.flFilterMinCutoff, tuning.flFilterBeta, tuning.flFilterDerivativeCutoff);
+
+		double flMinAngle = tuning.flPublishMinAngle * (3.14159265358979323846 / 180.0);
+		double flRateMultiple = tuning.flPublishRateMultiple;
+		double flMaxInterval = tuning.flPublishMaxInterval;
+		double flFrequency = GetDisplayFrequency();
+		double flMinInterval = flRateMultiple > 0 && flFrequency > 0 ? 1.0 / (flRateMultiple * flFrequency) : 0.0;
+		if (m_bVsyncAligned)
+			flMinInterval = 0.0;
+
+		m_publishThrottle.Configure(flMinAngle, flMinInterval, flMaxInterval);
+		m_publishThrottle.ClearSlot();
+		if (m_bVsyncAligned) {
+			DriverLog("Pose publishing: min angle %f rad, once per frame %f s before vsync, keep-alive %f s\n", flMinAngle, m_flVsyncPublishLead, flMaxInterval);
+		}
+		else {
+			DriverLog("Pose publishing: min angle %f rad, max rate %.0f Hz, keep-alive %f s\n", flMinAngle, flMinInterval > 0 ? 1.0 / flMinInterval : 0.0, flMaxInterval);
+		}
+		DriverLog("Pose prediction: horizon %f s, velocity window %f s\n", m_flPredictionHorizon, m_predictor.GetVelocityWindow());
+		if (m_filter.IsEnabled()) {
+			DriverLog("Orientation filter: min cutoff %f Hz, beta %f, derivative cutoff %f Hz\n", tuning.flFilterMinCutoff, tuning.flFilterBeta, tuning.flFilterDerivativeCutoff);
+		}
+		else {
+			DriverLog("Orientation filter: off\n");
+		}
+	}
+
+	// In vsync aligned mode each frame gets one publish slot starting
+	// m_flVsyncPublishLead seconds before its vsync, so the pose vrserver holds
+	// when the compositor asks for the next frame is the freshest one we have.
+	// The vsync reference comes from RunFrame() and may be a few frames old;
+	// the slots are extended from it at the display period.
+	void UpdateVsyncSlot(int64_t nNow)
+	{
+		int64_t nVsync = m_nLastVsync.load(std::memory_order_relaxed);
+		float flFrequency = m_bVsyncAligned ? GetDisplayFrequency() : 0.0f;
+		if (!m_bVsyncAligned || nVsync == 0 || flFrequency <= 0) {
+			m_publishThrottle.ClearSlot();
+			return;
+		}
+
+		int64_t nPeriod = GlyphSecondsToTicks(1.0 / flFrequency);
+		int64_t nPhase = nVsync - GlyphSecondsToTicks(m_flVsyncPublishLead);
+
+		// latest slot start at or before nNow
+		int64_t nFrames = nNow >= nPhase ? (nNow - nPhase) / nPeriod : -((nPhase - nNow + nPeriod - 1) / nPeriod);
+		int64_t nSlot = nPhase + nFrames * nPeriod;
+		m_publishThrottle.SetSlot(nSlot, nSlot + nPeriod);
+	}
+
+	// how long the tracking thread may sleep when no tracker report arrives
+	uint32_t GetWaitTimeoutMs(int64_t nNow) const
+	{
+		double flTimeout = m_bPublishedMotion ? k_flMaxPredictionAge : k_unSampleEventTimeoutMs / 1000.0;
+
+		int64_t nDue = m_publishThrottle.TicksUntilDue(nNow);
+		if (nDue >= 0 && GlyphTicksToSeconds(nDue) < flTimeout)
+			flTimeout = GlyphTicksToSeconds(nDue);
+
+		return (uint32_t)ceil(flTimeout * 1000.0);
+	}
+
+	// hand the samples just read to the recorder, oldest first
+	void RecordSamples(uint32_t unNewSamples)
+	{
+		if (unNewSamples > m_samples.Count())
+			unNewSamples = m_samples.Count();
+		for (uint32_t unAge = unNewSamples; unAge-- > 0; )
+			m_recorder.Append(m_samples.Get(unAge));
+	}
+
+	// Mark the pose connected or not, keeping the last orientation. A
+	// disconnected pose carries no motion and the predictor starts over when
+	// the tracker returns.
+	void StoreConnectedState(bool bConnected)
+	{
+		GlyphTrackerState_t state = m_trackerState.Load();
+		state.bConnected = bConnected;
+		if (!bConnected) {
+			for (int i = 0; i < 3; i++) {
+				state.vecAngularVelocity[i] = 0.0;
+				state.vecAngularAcceleration[i] = 0.0;
 			}
-			else {
-				std::this_thread::sleep_for(std::chrono::seconds(1));
+			m_predictor.Reset();
+			m_filter.Reset();
+			m_bPublishedMotion = false;
+		}
+		m_trackerState.Store(state);
+	}
+
+	// Reopen the tracker in place. Returns true once it is reading again.
+	bool ReconnectTracker(int64_t nNow)
+	{
+		m_pTracker->Stop();
+		m_pTracker->Close();
+		if (m_pTracker->Open()) {
+			m_pTracker->Start();
+		}
+
+		if (!m_pTracker->IsConnected()) {
+			m_trackerBackoff.OnFailure(nNow);
+			DRIVERLOG_DEBUG("Glyph tracker not found, next attempt in %.2f s\n", GlyphTicksToSeconds(m_trackerBackoff.TicksUntilDue(nNow)));
+			return false;
+		}
+
+		m_trackerBackoff.Reset();
+		m_bEventDriven = m_pTracker->GetWaitHandle() != GLYPH_NO_WAIT_HANDLE;
+		DriverLog("Glyph tracker reconnected on %s input\n", m_pTracker->GetName());
+		return true;
+	}
+
+	// Re-read the display mode and useSBS after Windows reports a change, or
+	// retry one that failed. The size sets the render target reported from
+	// now on and the refresh rate feeds the publish limits and vsync to
+	// photons; the compositor's window only moves when SteamVR restarts.
+	void RefreshDisplay(int64_t nNow)
+	{
+		GlyphDisplayInfo_t display;
+		if (!GlyphFindDisplay(m_unIndex, &display)) {
+			m_displayBackoff.OnFailure(nNow);
+			m_bDisplayPending = true;
+			DriverLog("Glyph display not found, retrying in %.2f s\n", GlyphTicksToSeconds(m_displayBackoff.TicksUntilDue(nNow)));
+			return;
+		}
+		m_displayBackoff.Reset();
+		m_bDisplayPending = false;
+
+		if (display.nX != m_nWindowX || display.nY != m_nWindowY || (int32_t)display.unWidth != m_nWindowWidth || (int32_t)display.unHeight != m_nWindowHeight) {
+			DriverLog("Glyph display moved to %d %d %u %u, restart SteamVR to render there\n", display.nX, display.nY, display.unWidth, display.unHeight);
+		}
+
+		// applications launched from now on render for the new mode
+		GlyphDisplayMode_t mode = m_displayMode.Load();
+		bool bFrequencyChanged = display.flFrequency != mode.flFrequency;
+		mode.nRenderWidth = display.unWidth;
+		mode.nRenderHeight = display.unHeight;
+		mode.flFrequency = display.flFrequency;
+		m_displayMode.Store(mode);
+		SetSideBySide(GlyphSettingBool(k_pch_Glyph_UseSBS_Bool, useSBS));
+
+		if (!bFrequencyChanged)
+			return;
+
+		DriverLog("Display Frequency: %f\n", mode.flFrequency);
+		LoadSecondsFromVsyncToPhotons();
+		if (m_ulPropertyContainer != vr::k_ulInvalidPropertyContainer) {
+			vr::VRProperties()->SetFloatProperty(m_ulPropertyContainer, Prop_DisplayFrequency_Float, mode.flFrequency);
+			vr::VRProperties()->SetFloatProperty(m_ulPropertyContainer, Prop_SecondsFromVsyncToPhotons_Float, m_flSecondsFromVsyncToPhotons.load());
+		}
+		ApplyTuning(m_tuning.Load());
+	}
+
+	// Act on hot plug notifications. While the tracker is missing the pose is
+	// reported disconnected once and the tracker is retried on the backoff
+	// schedule, or right away when a device arrives. Returns true when the
+	// tracker is connected, with bReconnected set if it has just come back.
+	bool UpdateConnection(bool *pbReconnected)
+	{
+		int64_t nNow = GlyphTicksNow();
+		*pbReconnected = false;
+
+		uint32_t unDisplayChanges = m_pDeviceWatcher->GetDisplayChangeCount();
+		if (unDisplayChanges != m_unSeenDisplayChanges || (m_bDisplayPending && m_displayBackoff.IsDue(nNow))) {
+			m_unSeenDisplayChanges = unDisplayChanges;
+			RefreshDisplay(nNow);
+		}
+
+		uint32_t unDeviceChanges = m_pDeviceWatcher->GetDeviceChangeCount();
+		if (unDeviceChanges != m_unSeenDeviceChanges) {
+			m_unSeenDeviceChanges = unDeviceChanges;
+			m_trackerBackoff.Reset();
+		}
+
+		if (!m_pTracker->IsConnected()) {
+			if (m_bTrackerConnected) {
+				DriverLog("Glyph tracker not connected, waiting for it\n");
+				m_bTrackerConnected = false;
+				m_trackerBackoff.OnFailure(nNow);
+				StoreConnectedState(false);
+				SendButtons(0, 0.0);
+				vr::VRServerDriverHost()->TrackedDevicePoseUpdated(m_unObjectId, GetPose(), sizeof(DriverPose_t));
+				m_publishThrottle.OnPublished(m_trackerState.Load().qRotation, nNow);
 			}
+			if (!m_trackerBackoff.IsDue(nNow) || !ReconnectTracker(nNow))
+				return false;
 		}
+
+		if (!m_bTrackerConnected) {
+			m_bTrackerConnected = true;
+			StoreConnectedState(true);
+			*pbReconnected = true;
+		}
+		return true;
 	}
 
-	virtual EVRInitError Activate(vr::TrackedDeviceIndex_t unObjectId)
+	// how long the tracking thread may sleep while the tracker is missing
+	uint32_t GetReconnectTimeoutMs(int64_t nNow) const
+	{
+		int64_t nDue = m_trackerBackoff.TicksUntilDue(nNow);
+		if (m_bDisplayPending)
+			nDue = std::min<int64_t>(nDue, m_displayBackoff.TicksUntilDue(nNow));
+		return (uint32_t)ceil(GlyphTicksToSeconds(nDue) * 1000.0);
+	}
+
+	// Copy the pose, counters and device state into the shared memory block.
+	// Tracking thread only.
+	void PublishTelemetry(int64_t nNow)
+	{
+		if (!m_telemetryPublisher.IsOpen())
+			return;
+
+		GlyphTrackerState_t state = m_trackerState.Load();
+		m_telemetry.nUpdateTime = nNow;
+		m_telemetry.nSampleTime = state.nTimestamp;
+		m_telemetry.nPoseTime = state.nPoseTimestamp;
+		m_telemetry.rgflRotation[0] = state.qRotation.w;
+		m_telemetry.rgflRotation[1] = state.qRotation.x;
+		m_telemetry.rgflRotation[2] = state.qRotation.y;
+		m_telemetry.rgflRotation[3] = state.qRotation.z;
+		for (int i = 0; i < 3; i++) {
+			m_telemetry.rgflAngularVelocity[i] = state.vecAngularVelocity[i];
+		}
+		m_telemetry.unSampleSequence = state.unSequence;
+
+		uint32_t unState = 0;
+		if (m_bTracking)
+			unState |= GlyphTelemetryState_Tracking;
+		if (m_pTracker->IsConnected())
+			unState |= GlyphTelemetryState_Connected;
+		if (m_bEventDriven)
+			unState |= GlyphTelemetryState_EventDriven;
+		if (m_bStandby)
+			unState |= GlyphTelemetryState_Standby;
+		if (m_bPublishedMotion)
+			unState |= GlyphTelemetryState_Moving;
+		if (m_recorder.IsOpen())
+			unState |= GlyphTelemetryState_Recording;
+		m_telemetry.unState = unState;
+
+		m_telemetry.ulSamplesRead = m_ulSamplesRead.load(std::memory_order_relaxed);
+		m_telemetry.ulSamplesDropped = m_ulSamplesDropped.load(std::memory_order_relaxed);
+		m_telemetry.ulPosesPublished = m_publishThrottle.GetPublishedCount();
+		m_telemetry.ulUpdatesSuppressed = m_publishThrottle.GetSuppressedCount();
+		m_telemetry.ulRecordDropped = m_recorder.GetDroppedCount();
+
+		if (nNow >= m_nNextTelemetryTiming) {
+			GetTelemetryTiming(m_stats.loopPeriod, &m_telemetry.loopPeriod);
+			GetTelemetryTiming(m_stats.readDuration, &m_telemetry.readDuration);
+			GetTelemetryTiming(m_stats.sampleAge, &m_telemetry.sampleAge);
+			GetTelemetryTiming(m_stats.publishDuration, &m_telemetry.publishDuration);
+			m_nNextTelemetryTiming = nNow + GlyphSecondsToTicks(k_flGlyphTelemetryTimingInterval);
+		}
+
+		m_telemetryPublisher.Publish(m_telemetry);
+	}
+
+	static void GetTelemetryTiming(const CGlyphHistogram &histogram, GlyphTelemetryTiming_t *pTiming)
+	{
+		pTiming->ulCount = histogram.GetCount();
+		pTiming->unMeanMicroseconds = (uint32_t)histogram.GetMeanMicroseconds();
+		pTiming->unP99Microseconds = histogram.GetPercentileMicroseconds(0.99);
+		pTiming->unMaxMicroseconds = histogram.GetMaxMicroseconds();
+		pTiming->unReserved = 0;
+	}
+
+	void LogStats() const
+	{
+		char rchSummary[128];
+		m_stats.loopPeriod.Format(rchSummary, sizeof(rchSummary));
+		DriverLog("Tracking loop period: %s\n", rchSummary);
+		m_stats.readDuration.Format(rchSummary, sizeof(rchSummary));
+		DriverLog("Tracker read duration: %s\n", rchSummary);
+		m_stats.sampleAge.Format(rchSummary, sizeof(rchSummary));
+		DriverLog("Sample age at GetPose: %s\n", rchSummary);
+		m_stats.publishDuration.Format(rchSummary, sizeof(rchSummary));
+		DriverLog("Pose publish duration: %s\n", rchSummary);
+	}
+
+	// Standby: release the tracker and publish nothing until LeaveStandby or
+	// deactivation. The device stays open, so resuming only acquires it again.
+	void ParkTracking()
+	{
+		DriverLog("%s tracking parked for standby\n", m_sSerialNumber.c_str());
+		m_pTracker->Stop();
+		m_bParked = true;
+	}
+
+	void ResumeTracking()
 	{
-		g_deviceIsActive = TRUE;
-		gamepadPollingThread = new std::thread (CGlyphDeviceDriver::staticPollGamepad, this);
-		if (!gamepadPollingThread) {
-			DriverLog("Error starting head tracking thread\n");
+		// motion from before standby says nothing about the head now
+		m_pTracker->Start();
+		m_samples.Clear();
+		m_predictor.Reset();
+		m_filter.Reset();
+		m_bPublishedMotion = false;
+		m_bEventDriven = m_pTracker->GetWaitHandle() != GLYPH_NO_WAIT_HANDLE;
+		m_bParked = false;
+		m_nLastLoop = 0;
+		DriverLog("%s tracking resumed from standby\n", m_sSerialNumber.c_str());
+	}
+
+	// An input component for each button the tracker has, as
+	// "/input/button1/click" onwards. Runs at Activate, or on the tracking
+	// thread when a tracker missing then is first connected.
+	void CreateButtonComponents()
+	{
+		if (m_unButtonComponents || !m_pTracker->IsOpen())
+			return;
+
+		uint32_t unButtons = m_pTracker->GetButtonCount();
+		for (uint32_t i = 0; i < unButtons; i++) {
+			char rchPath[32];
+#if defined( _WIN32 )
+			sprintf_s(rchPath, "/input/button%u/click", i + 1);
+#else
+			snprintf(rchPath, sizeof(rchPath), "/input/button%u/click", i + 1);
+#endif
+			m_rgButtonComponents[i] = vr::k_ulInvalidInputComponentHandle;
+			vr::VRDriverInput()->CreateBooleanComponent(m_ulPropertyContainer, rchPath, &m_rgButtonComponents[i]);
+		}
+		m_unButtonComponents = unButtons;
+		m_unSentButtons = 0;
+		if (unButtons) {
+			DriverLog("%s has %u button%s\n", m_sSerialNumber.c_str(), unButtons, unButtons == 1 ? "" : "s");
+		}
+	}
+
+	// Send the buttons that changed in each new sample, oldest first, so a
+	// press and release between two passes still arrive as a click
+	void UpdateButtons(uint32_t unNewSamples, int64_t nNow)
+	{
+		if (!m_unButtonComponents)
+			return;
+
+		uint32_t unMask = m_unButtonComponents < 32 ? (1u << m_unButtonComponents) - 1 : ~0u;
+		if (unNewSamples > m_samples.Count())
+			unNewSamples = m_samples.Count();
+		for (uint32_t unAge = unNewSamples; unAge-- > 0; ) {
+			const GlyphSample_t &sample = m_samples.Get(unAge);
+			SendButtons(sample.unButtons & unMask, -GlyphTicksToSeconds(nNow - sample.nTimestamp));
 		}
+	}
 
+	void SendButtons(uint32_t unButtons, double flTimeOffset)
+	{
+		uint32_t unChanged = unButtons ^ m_unSentButtons;
+		for (uint32_t i = 0; unChanged; i++, unChanged >>= 1) {
+			if (unChanged & 1) {
+				vr::VRDriverInput()->UpdateBooleanComponent(m_rgButtonComponents[i], (unButtons & (1u << i)) != 0, flTimeOffset);
+			}
+		}
+		m_unSentButtons = unButtons;
+	}
+
+	// IGlyphTrackingClient, called on the tracking thread between Activate and Deactivate
+	virtual void BeginTracking(const CGlyphDeviceWatcher *pWatcher)
+	{
+		m_pTracker->Start();
+		m_bEventDriven = m_pTracker->GetWaitHandle() != GLYPH_NO_WAIT_HANDLE;
+		DriverLog("%s tracking on %s input, %s\n", m_sSerialNumber.c_str(), m_pTracker->GetName(), m_bEventDriven ? "event driven" : "polling");
+
+		m_stats.Reset();
+		m_ulSamplesRead = 0;
+		m_ulSamplesDropped = 0;
+		m_nTrackingStart = GlyphTicksNow();
+		m_nLastLoop = 0;
+		m_unTuningVersion = m_tuning.Version();
+		ApplyTuning(m_tuning.Load());
+
+		if (!m_sRecordPath.empty()) {
+			m_recorder.Open(m_sRecordPath.c_str(), m_pTracker->GetButtonCount());
+		}
+
+		m_pDeviceWatcher = pWatcher;
+		m_unSeenDeviceChanges = pWatcher->GetDeviceChangeCount();
+		m_unSeenDisplayChanges = pWatcher->GetDisplayChangeCount();
+		m_bTrackerConnected = true;
+		m_trackerBackoff.Reset();
+		m_bParked = false;
+
+		m_bTracking = true;
+		m_nNextTelemetryTiming = 0;
+		PublishTelemetry(GlyphTicksNow());
+	}
+
+	virtual void ServiceTracking(GlyphTrackingWait_t *pWait)
+	{
+		if (m_tuning.Version() != m_unTuningVersion) {
+			m_unTuningVersion = m_tuning.Version();
+			ApplyTuning(m_tuning.Load());
+		}
+
+		if (m_bStandby) {
+			if (!m_bParked) {
+				ParkTracking();
+				PublishTelemetry(GlyphTicksNow());
+			}
+			return;
+		}
+		bool bResumed = m_bParked;
+		if (bResumed) {
+			ResumeTracking();
+		}
+
+		bool bReconnected;
+		if (!UpdateConnection(&bReconnected)) {
+			// sleep until a device arrives or the next attempt is due
+			int64_t nNow = GlyphTicksNow();
+			pWait->unTimeoutMs = GetReconnectTimeoutMs(nNow);
+			m_nLastLoop = 0;
+			PublishTelemetry(nNow);
+			return;
+		}
+		if (bReconnected) {
+			CreateButtonComponents();
+		}
+
+		int64_t nReadStart = GlyphTicksNow();
+		if (m_nLastLoop) {
+			m_stats.loopPeriod.Record(nReadStart - m_nLastLoop);
+		}
+		m_nLastLoop = nReadStart;
+
+		uint32_t unNewSamples = m_pTracker->ReadSamples(&m_samples);
+		int64_t nNow = GlyphTicksNow();
+		m_stats.readDuration.Record(nNow - nReadStart);
+		m_ulSamplesRead.fetch_add(unNewSamples, std::memory_order_relaxed);
+		if (m_recorder.IsOpen()) {
+			RecordSamples(unNewSamples);
+		}
+		bool bForce = bReconnected || bResumed;
+
+		if (unNewSamples > 0) {
+			DecodeSamples(unNewSamples);
+		}
+		else if (SettleStaleMotion(nNow)) {
+			bForce = true;
+		}
+
+		UpdateVsyncSlot(nNow);
+		HmdQuaternion_t qRotation = m_trackerState.Load().qRotation;
+		if (m_publishThrottle.Update(qRotation, unNewSamples > 0, bForce, nNow)) {
+			vr::VRServerDriverHost()->TrackedDevicePoseUpdated(m_unObjectId, GetPose(), sizeof(DriverPose_t));
+			m_stats.publishDuration.Record(GlyphTicksNow() - nNow);
+			m_publishThrottle.OnPublished(qRotation, nNow);
+		}
+		UpdateButtons(unNewSamples, nNow);
+		PublishTelemetry(nNow);
+
+		// sleep until the tracker has a new report or a held back pose is due
+		pWait->hEvent = m_pTracker->GetWaitHandle();
+		if (pWait->hEvent != GLYPH_NO_WAIT_HANDLE) {
+			pWait->unTimeoutMs = GetWaitTimeoutMs(nNow);
+		}
+		else {
+			pWait->bPoll = true;
+		}
+	}
+
+	virtual void EndTracking()
+	{
+		m_pTracker->Stop();
+		m_recorder.Close();
+		m_pDeviceWatcher = NULL;
+		m_bTracking = false;
+		PublishTelemetry(GlyphTicksNow());
+		DriverLog("%s tracking published %llu poses, suppressed %llu updates\n", m_sSerialNumber.c_str(), m_publishThrottle.GetPublishedCount(), m_publishThrottle.GetSuppressedCount());
+		LogStats();
+	}
+
+	virtual EVRInitError Activate(vr::TrackedDeviceIndex_t unObjectId)
+	{
 		m_unObjectId = unObjectId;
 		m_ulPropertyContainer = vr::VRProperties()->TrackedDeviceToPropertyContainer(m_unObjectId);
+		LoadOptics();
+		LoadAxisMapping();
+
+		// SteamVR Input binds the button components through this profile, so
+		// it must be set before they are created
+		vr::VRProperties()->SetStringProperty(m_ulPropertyContainer, Prop_ControllerType_String, "glyph");
+		vr::VRProperties()->SetStringProperty(m_ulPropertyContainer, Prop_InputProfilePath_String, "{glyph}/input/glyph_profile.json");
+		CreateButtonComponents();
+
+		if (GlyphSettingBool(k_pch_Glyph_Telemetry_Bool, true)) {
+			m_telemetryPublisher.Open(m_unIndex);
+		}
+
+		// the tracking thread reads m_unObjectId, the axis kernel and the input
+		// components, so hand the device over only once those are set
+		m_bStandby = false;
+		g_trackingThread.AddClient(this);
 
 		vr::VRProperties()->SetStringProperty(m_ulPropertyContainer, Prop_ModelNumber_String, m_sModelNumber.c_str());
 		vr::VRProperties()->SetStringProperty(m_ulPropertyContainer, Prop_RenderModelName_String, m_sModelNumber.c_str());
 		vr::VRProperties()->SetFloatProperty(m_ulPropertyContainer, Prop_UserIpdMeters_Float, m_flIPD);
 		vr::VRProperties()->SetFloatProperty(m_ulPropertyContainer, Prop_UserHeadToEyeDepthMeters_Float, 0.f);
-		vr::VRProperties()->SetFloatProperty(m_ulPropertyContainer, Prop_DisplayFrequency_Float, m_flDisplayFrequency);
-		vr::VRProperties()->SetFloatProperty(m_ulPropertyContainer, Prop_SecondsFromVsyncToPhotons_Float, m_flSecondsFromVsyncToPhotons);
+		vr::VRProperties()->SetFloatProperty(m_ulPropertyContainer, Prop_DisplayFrequency_Float, GetDisplayFrequency());
+		vr::VRProperties()->SetFloatProperty(m_ulPropertyContainer, Prop_SecondsFromVsyncToPhotons_Float, m_flSecondsFromVsyncToPhotons.load());
 
 		// return a constant that's not 0 (invalid) or 1 (reserved for Oculus)
 		vr::VRProperties()->SetUint64Property(m_ulPropertyContainer, Prop_CurrentUniverseId_Uint64, 2);
@@ -402,29 +1696,39 @@ public:
 			vr::VRProperties()->SetStringProperty(m_ulPropertyContainer, vr::Prop_NamedIconPathDeviceAlertLow_String, "{sample}/icons/headset_sample_status_ready_low.png");
 		}
 
-		//return (found ? VRInitError_None : VRInitError_Init_HmdNotFound);
-		//return VRInitError_None;
-		return lpdiJoystick != NULL ? VRInitError_None : VRInitError_Init_HmdNotFound;
+		// a tracker plugged in later is picked up by the head tracking thread;
+		// until then the pose reports the headset disconnected
+		return VRInitError_None;
 	}
 
 	virtual void Deactivate()
 	{
-		g_deviceIsActive = FALSE;
-		if (gamepadPollingThread) {
-			gamepadPollingThread->join();
-			delete gamepadPollingThread;
-			gamepadPollingThread = NULL;
-		}
+		g_trackingThread.RemoveClient(this);
+		m_telemetryPublisher.Close();
 		m_unObjectId = vr::k_unTrackedDeviceIndexInvalid;
 	}
 
 	virtual void EnterStandby()
 	{
+		SetStandby(true);
+	}
+
+	void LeaveStandby()
+	{
+		SetStandby(false);
+	}
+
+	void SetStandby(bool bStandby)
+	{
+		if (m_bStandby.exchange(bStandby) != bStandby) {
+			g_trackingThread.Wake();
+		}
 	}
 
 	void *GetComponent(const char *pchComponentNameAndVersion)
 	{
-		if (!_stricmp(pchComponentNameAndVersion, vr::IVRDisplayComponent_Version))
+		// SteamVR drives one HMD; further Glyphs are orientation trackers without a display
+		if (!_stricmp(pchComponentNameAndVersion, vr::IVRDisplayComponent_Version) && m_unIndex == 0)
 		{
 			return (vr::IVRDisplayComponent*)this;
 		}
@@ -433,15 +1737,27 @@ public:
 		return NULL;
 	}
 
+	// the Glyph has no power control of its own, so off is the same as standby
 	virtual void PowerOff()
 	{
+		SetStandby(true);
 	}
 
 	/** debug request from a client */
 	virtual void DebugRequest(const char *pchRequest, char *pchResponseBuffer, uint32_t unResponseBufferSize)
 	{
-		if (unResponseBufferSize >= 1)
-			pchResponseBuffer[0] = 0;
+		CGlyphDebugResponse response(pchResponseBuffer, unResponseBufferSize);
+
+		char rchCommand[32];
+		const char *pchArgs = GlyphNextDebugWord(pchRequest, rchCommand, sizeof(rchCommand));
+
+		for (const DebugCommand_t *pCommand = k_rgDebugCommands; pCommand->pchName; pCommand++) {
+			if (!strcmp(rchCommand, pCommand->pchName)) {
+				(this->*pCommand->pfnHandler)(pchArgs, response);
+				return;
+			}
+		}
+		response.Printf("unknown command \"%s\", try \"help\"\n", rchCommand);
 	}
 
 	virtual void GetWindowBounds(int32_t *pnX, int32_t *pnY, uint32_t *pnWidth, uint32_t *pnHeight)
@@ -464,57 +1780,44 @@ public:
 
 	virtual void GetRecommendedRenderTargetSize(uint32_t *pnWidth, uint32_t *pnHeight)
 	{
-		*pnWidth = m_nRenderWidth;
-		*pnHeight = m_nRenderHeight;
+		float flScale = m_flRenderTargetScale.load(std::memory_order_relaxed);
+		GlyphDisplayMode_t mode = m_displayMode.Load();
+		*pnWidth = (uint32_t)(mode.nRenderWidth / (int32_t)GetEyeColumns() * flScale + 0.5f);
+		*pnHeight = (uint32_t)(mode.nRenderHeight * flScale + 0.5f);
 	}
 
 	virtual void GetEyeOutputViewport(EVREye eEye, uint32_t *pnX, uint32_t *pnY, uint32_t *pnWidth, uint32_t *pnHeight)
 	{
-		if (useSBS) {
-			*pnWidth = m_nWindowWidth / 2;
-		}
-		else {
-			*pnWidth = m_nWindowWidth;
-		}
+		uint32_t unColumns = GetEyeColumns();
+		*pnWidth = m_nWindowWidth / unColumns;
 		*pnHeight = m_nWindowHeight;
+		*pnX = eEye == Eye_Right && unColumns > 1 ? *pnWidth : 0;
+		*pnY = 0;
 
-		if (eEye == Eye_Left)
-		{
-			*pnX = 0;
-			*pnY = 0;
+		// the compositor asks for this every frame; one line per eye every 10 s is plenty
+		if (eEye == Eye_Left) {
+			DRIVERLOG_RATE_LIMITED(DriverLogLevel_Info, 10000, "GetEyeOutput Left Eye (%i, %i, %i, %i)\n", *pnX, *pnY, *pnWidth, *pnHeight);
 		}
-		else
-		{
-			if (useSBS) {
-				*pnX = m_nWindowWidth / 2;
-				*pnY = 0;
-			}
-			else {
-				*pnX = 0;
-				*pnY = 0;
-			}
+		else {
+			DRIVERLOG_RATE_LIMITED(DriverLogLevel_Info, 10000, "GetEyeOutput Right Eye (%i, %i, %i, %i)\n", *pnX, *pnY, *pnWidth, *pnHeight);
 		}
-
-		DriverLog("GetEyeOutput %s (%i, %i, %i, %i)\n", eEye == Eye_Left?"Left Eye":"Right Eye", *pnX, *pnY, *pnWidth, *pnHeight);
 	}
 
 	virtual void GetProjectionRaw(EVREye eEye, float *pfLeft, float *pfRight, float *pfTop, float *pfBottom)
 	{
-		*pfLeft = -1.0;
-		*pfRight = 1.0;
-		*pfTop = -1.0;
-		*pfBottom = 1.0;
+		GlyphGetProjection(m_optics, eEye, pfLeft, pfRight, pfTop, pfBottom);
 	}
 
+	// The three term model evaluates in about half the time a bilinear grid
+	// lookup takes (glyph_bench), so it is evaluated directly
 	virtual DistortionCoordinates_t ComputeDistortion(EVREye eEye, float fU, float fV)
 	{
+		if (m_bDistortion)
+			return GlyphEvaluateDistortion(m_optics, eEye, fU, fV);
+
 		DistortionCoordinates_t coordinates;
-		coordinates.rfBlue[0] = fU;
-		coordinates.rfBlue[1] = fV;
-		coordinates.rfGreen[0] = fU;
-		coordinates.rfGreen[1] = fV;
-		coordinates.rfRed[0] = fU;
-		coordinates.rfRed[1] = fV;
+		coordinates.rfRed[0] = coordinates.rfGreen[0] = coordinates.rfBlue[0] = fU;
+		coordinates.rfRed[1] = coordinates.rfGreen[1] = coordinates.rfBlue[1] = fV;
 		return coordinates;
 	}
 
@@ -524,18 +1827,32 @@ public:
 		pose.poseIsValid = true;
 		pose.result = TrackingResult_Running_OK;
 		pose.deviceIsConnected = true;
-		pose.poseTimeOffset = -0.016f;
 
 		pose.qWorldFromDriverRotation = HmdQuaternion_Init(1, 0, 0, 0);
 		pose.qDriverFromHeadRotation = HmdQuaternion_Init(1, 0, 0, 0);
 
-		double degX = (360.0 / 65535.0) * (joyState.lZ) + 180;
-		double degY = (360.0 / 65535.0) * (joyState.lRx) + 180;
-		double degZ = -(360.0 / 65535.0) * (joyState.lY) + 180;
+		GlyphTrackerState_t state = m_trackerState.Load();
+		pose.qRotation = state.qRotation;
 
-		pose.qRotation = HmdQuaternion_Rotate(degX, degY, degZ);
+		if (!state.bConnected) {
+			pose.poseIsValid = false;
+			pose.result = TrackingResult_Running_OutOfRange;
+			pose.deviceIsConnected = false;
+			return pose;
+		}
+
+		// negative while the pose describes the past; SteamVR extrapolates the rest
+		int64_t nAge = GlyphTicksNow() - state.nTimestamp;
+		m_stats.sampleAge.Record(nAge);
 
-		//DriverLog("Values x: %f, y: %f, z: %f, w: %f, degX: %f, degY: %f, degZ: %f, lX: %ld, lY: %ld, lZ: %ld\n", pose.qRotation.x, pose.qRotation.y, pose.qRotation.z, pose.qRotation.w, degX, degY, degZ, joyState.lX, joyState.lY, joyState.lZ);
+		double flAge = GlyphTicksToSeconds(nAge);
+		pose.poseTimeOffset = GlyphTicksToSeconds(state.nPoseTimestamp - state.nTimestamp) - flAge;
+		if (flAge < k_flMaxPredictionAge) {
+			for (int i = 0; i < 3; i++) {
+				pose.vecAngularVelocity[i] = state.vecAngularVelocity[i];
+				pose.vecAngularAcceleration[i] = state.vecAngularAcceleration[i];
+			}
+		}
 
 		return pose;
 	}
@@ -543,9 +1860,21 @@ public:
 
 	void RunFrame()
 	{
+		if (m_bAdaptiveRenderTarget && m_unIndex == 0) {
+			UpdateRenderTargetScale();
+		}
+
+		if (m_bVsyncAligned) {
+			float flSecondsSinceVsync;
+			uint64_t ulFrameCounter;
+			if (vr::VRServerDriverHost()->GetTimeSinceLastVsync(&flSecondsSinceVsync, &ulFrameCounter)) {
+				m_nLastVsync.store(GlyphTicksNow() - GlyphSecondsToTicks(flSecondsSinceVsync), std::memory_order_relaxed);
+			}
+		}
 	}
 
 	std::string GetSerialNumber() const { return m_sSerialNumber; }
+	vr::ETrackedDeviceClass GetDeviceClass() const { return m_unIndex == 0 ? vr::TrackedDeviceClass_HMD : vr::TrackedDeviceClass_GenericTracker; }
 
 private:
 	vr::TrackedDeviceIndex_t m_unObjectId;
@@ -558,13 +1887,27 @@ private:
 	int32_t m_nWindowY;
 	int32_t m_nWindowWidth;
 	int32_t m_nWindowHeight;
-	int32_t m_nRenderWidth;
-	int32_t m_nRenderHeight;
-	float m_flSecondsFromVsyncToPhotons;
-	float m_flDisplayFrequency;
+
+	// stored by the tracking thread when the display changes; vsync to
+	// photons is also set by the "vsync_to_photons" debug request
+	CGlyphSeqLock<GlyphDisplayMode_t> m_displayMode;
+	std::atomic<float> m_flSecondsFromVsyncToPhotons;
 	float m_flIPD;
 };
 
+// commands understood by CGlyphDeviceDriver::DebugRequest
+const CGlyphDeviceDriver::DebugCommand_t CGlyphDeviceDriver::k_rgDebugCommands[] =
+{
+	{ "help", "help", &CGlyphDeviceDriver::DebugHelp },
+	{ "stats", "stats [reset]", &CGlyphDeviceDriver::DebugStats },
+	{ "backend", "backend", &CGlyphDeviceDriver::DebugBackend },
+	{ "get", "get", &CGlyphDeviceDriver::DebugGet },
+	{ "set", "set <key> <value>", &CGlyphDeviceDriver::DebugSet },
+	{ "save", "save", &CGlyphDeviceDriver::DebugSave },
+	{ "vsync_to_photons", "vsync_to_photons [<seconds> | estimate]", &CGlyphDeviceDriver::CalibrateVsyncToPhotons },
+	{ NULL, NULL, NULL },
+};
+
 //-----------------------------------------------------------------------------
 // Purpose:
 //-----------------------------------------------------------------------------
@@ -572,8 +1915,7 @@ class CServerDriver_Glyph : public IServerTrackedDeviceProvider
 {
 public:
 	CServerDriver_Glyph()
-		: m_pNullHmdLatest(NULL)
-		, m_bEnableNullDriver(false)
+		: m_bEnableNullDriver(false)
 	{
 	}
 
@@ -582,11 +1924,11 @@ public:
 	virtual const char * const *GetInterfaceVersions() { return vr::k_InterfaceVersions; }
 	virtual void RunFrame();
 	virtual bool ShouldBlockStandbyMode() { return false; }
-	virtual void EnterStandby() {}
-	virtual void LeaveStandby() {}
+	virtual void EnterStandby();
+	virtual void LeaveStandby();
 
 private:
-	CGlyphDeviceDriver *m_pNullHmdLatest;
+	std::vector<CGlyphDeviceDriver *> m_vecDevices;
 
 	bool m_bEnableNullDriver;
 };
@@ -594,29 +1936,78 @@ private:
 CServerDriver_Glyph g_serverDriverNull;
 
 
+// log threshold from the settings, "info" unless configured otherwise
+static void ApplyLogLevelSetting()
+{
+	char rchLevel[16];
+	GlyphSettingString(k_pch_Glyph_LogLevel_String, rchLevel, sizeof(rchLevel), "info");
+
+	EDriverLogLevel eLevel;
+	if (!ParseDriverLogLevel(rchLevel, &eLevel)) {
+		DriverLogWithLevel(DriverLogLevel_Warning, "Unknown %s \"%s\", using info\n", k_pch_Glyph_LogLevel_String, rchLevel);
+		eLevel = DriverLogLevel_Info;
+	}
+	SetDriverLogLevel(eLevel);
+#if !DRIVERLOG_ENABLE_DEBUG
+	if (eLevel == DriverLogLevel_Debug) {
+		DriverLog("Debug logging is compiled out of this build\n");
+	}
+#endif
+}
+
+
 EVRInitError CServerDriver_Glyph::Init(vr::IVRDriverContext *pDriverContext)
 {
 	VR_INIT_SERVER_DRIVER_CONTEXT(pDriverContext);
-	InitDriverLog(vr::VRDriverLog());
+	InitDriverLog(vr::VRDriverLog(), GlyphSettingBool(k_pch_Glyph_AsyncLog_Bool, true));
+	ApplyLogLevelSetting();
+
+	// Each tracker opened claims the next Glyph not already taken. With no
+	// configured count, devices are added while trackers are found; the first
+	// is added even without one so it can be plugged in later.
+	int32_t nDeviceCount = GlyphSettingInt32(k_pch_Glyph_DeviceCount_Int32, 0);
+	uint32_t unMaxDevices = nDeviceCount > 0 ? std::min<uint32_t>((uint32_t)nDeviceCount, k_unMaxGlyphDevices) : k_unMaxGlyphDevices;
+	for (uint32_t i = 0; i < unMaxDevices; i++) {
+		IGlyphTrackerInput *pTracker = OpenGlyphTracker(i, i == 0);
+		if (nDeviceCount <= 0 && i > 0 && !pTracker->IsOpen()) {
+			delete pTracker;
+			break;
+		}
 
-	m_pNullHmdLatest = new CGlyphDeviceDriver();
-	vr::VRServerDriverHost()->TrackedDeviceAdded(m_pNullHmdLatest->GetSerialNumber().c_str(), vr::TrackedDeviceClass_HMD, m_pNullHmdLatest);
+		CGlyphDeviceDriver *pDevice = new CGlyphDeviceDriver(i, pTracker);
+		m_vecDevices.push_back(pDevice);
+		vr::VRServerDriverHost()->TrackedDeviceAdded(pDevice->GetSerialNumber().c_str(), pDevice->GetDeviceClass(), pDevice);
+	}
+	DriverLog("%u Glyph device%s added\n", (uint32_t)m_vecDevices.size(), m_vecDevices.size() == 1 ? "" : "s");
 	return VRInitError_None;
 }
 
+void CServerDriver_Glyph::EnterStandby()
+{
+	for (size_t i = 0; i < m_vecDevices.size(); i++)
+		m_vecDevices[i]->EnterStandby();
+}
+
+void CServerDriver_Glyph::LeaveStandby()
+{
+	for (size_t i = 0; i < m_vecDevices.size(); i++)
+		m_vecDevices[i]->LeaveStandby();
+}
+
 void CServerDriver_Glyph::Cleanup()
 {
 	CleanupDriverLog();
-	delete m_pNullHmdLatest;
-	m_pNullHmdLatest = NULL;
+	for (size_t i = 0; i < m_vecDevices.size(); i++)
+		delete m_vecDevices[i];
+	m_vecDevices.clear();
 }
 
 
 void CServerDriver_Glyph::RunFrame()
 {
-	if (m_pNullHmdLatest)
+	for (size_t i = 0; i < m_vecDevices.size(); i++)
 	{
-		m_pNullHmdLatest->RunFrame();
+		m_vecDevices[i]->RunFrame();
 	}
 }
 